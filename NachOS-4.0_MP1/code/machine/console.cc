@@ -120,6 +120,7 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall) {
 
     callWhenDone = toCall;
     putBusy = FALSE;
+    numPut = 0;
 }
 
 //----------------------------------------------------------------------
@@ -135,13 +136,13 @@ ConsoleOutput::~ConsoleOutput() {
 //----------------------------------------------------------------------
 // ConsoleOutput::CallBack()
 // 	Simulator calls this when the next character can be output to the
-//	display.
+//	display, or the next buffer, once the last one is all out.
 //----------------------------------------------------------------------
 
 void ConsoleOutput::CallBack() {
     DEBUG(dbgTraCode, "In ConsoleOutput::CallBack(), " << kernel->stats->totalTicks);
     putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
+    kernel->stats->numConsoleCharsWritten += numPut;
     callWhenDone->CallBack();
 }
 
@@ -155,5 +156,22 @@ void ConsoleOutput::PutChar(char ch) {
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
+    numPut = 1;
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
 }
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutBuffer()
+// 	Write "size" characters from "buffer" to the simulated display,
+//	schedule an interrupt to occur once the last of them would be
+//	out, and return.  The caller may re-use "buffer" right away.
+//----------------------------------------------------------------------
+
+void ConsoleOutput::PutBuffer(char *buffer, int size) {
+    ASSERT(putBusy == FALSE);
+    ASSERT(size > 0);
+    WriteFile(writeFileNo, buffer, size);
+    putBusy = TRUE;
+    numPut = size;
+    kernel->interrupt->Schedule(this, ConsoleTime * size, ConsoleWriteInt);
+}
@@ -18,6 +18,11 @@
 //	for read and write, and the device is "duplex" -- a character
 //	can be outgoing and incoming at the same time.
 //
+//	The display can also be handed a whole buffer at once, as a
+//	DMA controller would: it still takes the time of sending each
+//	character, but there is just one interrupt, when all of them
+//	are out.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
@@ -76,6 +81,10 @@ class ConsoleOutput : public CallBackObj {
     void PutChar(char ch);  // Write "ch" to the console display,
                             // and return immediately.  "callWhenDone"
                             // will called when the I/O completes.
+    void PutBuffer(char *buffer, int size);
+    // Write "size" characters to the
+    // display, and return immediately;
+    // likewise, with one interrupt
     void CallBack();        // Invoked when next character can be put
                             // out to the display.
     void PutInt(int n);     // Write n to the console display
@@ -86,6 +95,7 @@ class ConsoleOutput : public CallBackObj {
                                 // the next char can be put
     bool putBusy;               // Is a PutChar operation in progress?
                                 // If so, you can't do another one!
+    int numPut;                 // characters in the operation in progress
 };
 
 #endif  // CONSOLE_H
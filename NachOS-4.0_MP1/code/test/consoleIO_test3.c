@@ -0,0 +1,12 @@
+#include "syscall.h"
+
+int main() {
+	int n;
+	PrintString("Counting down:\n");
+	for (n=9; n>5; n--) {
+		PrintInt(n);
+	}
+	PrintString("Done.\n");
+	return 0;
+	//Halt();
+}
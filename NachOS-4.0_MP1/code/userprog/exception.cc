@@ -90,6 +90,20 @@ void ExceptionHandler(ExceptionType which) {
                     ASSERTNOTREACHED();
                     break;
 
+                // print the string at the addr in reg 4
+                case SC_PrintString:
+                    DEBUG(dbgSys, "Print String\n");
+                    // the addr of the string is in reg 4
+                    val = kernel->machine->ReadRegister(4);
+                    SysPrintString(val);
+                    // renew the PrevPCReg、PCReg and NextPCReg, the same as sc_printint
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+
                 // call the msg to print the message store in the reg
                 case SC_MSG:
                     DEBUG(dbgSys, "Message received.\n");
@@ -28,6 +28,23 @@ void SysPrintInt(int val) {
     DEBUG(dbgTraCode, "In ksyscall.h:SysPrintInt, return from synchConsoleOut->PutInt, " << kernel->stats->totalTicks);
 }
 
+void SysPrintString(int addr) {
+    // copy the string at addr into a kernel buffer, and print it a
+    // buffer at a time; stop at the end of memory, even if the string
+    // is not terminated by then
+    char buf[128];
+    int n = 0;
+
+    while (addr >= 0 && addr < MemorySize && kernel->machine->mainMemory[addr] != '\0') {
+        buf[n++] = kernel->machine->mainMemory[addr++];
+        if (n == sizeof(buf)) {
+            kernel->synchConsoleOut->PutBytes(buf, n);
+            n = 0;
+        }
+    }
+    kernel->synchConsoleOut->PutBytes(buf, n);  // nothing if n is 0
+}
+
 int SysAdd(int op1, int op2) {
     return op1 + op2;
 }
@@ -97,22 +97,48 @@ void SynchConsoleOutput::PutChar(char ch) {
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutInt
+//      Write an integer and a newline to the console display, all in
+//	one transfer, waiting if necessary.
+//----------------------------------------------------------------------
+
 void SynchConsoleOutput::PutInt(int value) {
     char str[15];
-    int idx = 0;
     // sprintf(str, "%d\n\0", value);  the true one
     sprintf(str, "%d\n\0", value);  // simply for trace code
+    PutString(str);
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutString
+//      Write a null-terminated string to the console display, waiting
+//	if necessary.
+//----------------------------------------------------------------------
+
+void SynchConsoleOutput::PutString(char *str) {
+    PutBytes(str, strlen(str));
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutBytes
+//      Write "size" characters to the console display, waiting until
+//	they are all out.  They go to the device as one buffer, so the
+//	writer waits for one interrupt, not one per character.
+//----------------------------------------------------------------------
+
+void SynchConsoleOutput::PutBytes(char *buffer, int size) {
+    if (size <= 0) {
+        return;
+    }
     lock->Acquire();
-    do {
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, into consoleOutput->PutChar, " << kernel->stats->totalTicks);
-        consoleOutput->PutChar(str[idx]);
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, return from consoleOutput->PutChar, " << kernel->stats->totalTicks);
-        idx++;
-
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, into waitFor->P(), " << kernel->stats->totalTicks);
-        waitFor->P();
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, return form  waitFor->P(), " << kernel->stats->totalTicks);
-    } while (str[idx] != '\0');
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutBytes, into consoleOutput->PutBuffer, " << kernel->stats->totalTicks);
+    consoleOutput->PutBuffer(buffer, size);
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutBytes, return from consoleOutput->PutBuffer, " << kernel->stats->totalTicks);
+
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutBytes, into waitFor->P(), " << kernel->stats->totalTicks);
+    waitFor->P();
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutBytes, return from waitFor->P(), " << kernel->stats->totalTicks);
     lock->Release();
 }
 
@@ -43,6 +43,10 @@ class SynchConsoleOutput : public CallBackObj {
     void PutChar(char ch);  // Write a character, waiting if necessary
 
     void PutInt(int n);
+    void PutString(char *str);  // Write a null-terminated string
+    void PutBytes(char *buffer, int size);
+    // Write "size" characters at once,
+    // waiting for all of them
 
    private:
     ConsoleOutput *consoleOutput;  // the hardware display
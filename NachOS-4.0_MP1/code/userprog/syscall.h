@@ -35,6 +35,7 @@
 #define SC_ThreadExit 14
 #define SC_ThreadJoin 15
 #define SC_PrintInt 16
+#define SC_PrintString 17
 #define SC_Add 42
 #define SC_MSG 100
 #ifndef IN_ASM
@@ -54,6 +55,9 @@ void Halt();
 
 /* Print Integer */
 void PrintInt(int number);
+
+/* Print a null-terminated string to the console, all in one transfer */
+void PrintString(char *str);
 /*
  * Add the two operants and return the result
  */
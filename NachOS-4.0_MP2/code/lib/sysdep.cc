@@ -143,6 +143,19 @@ void UDelay(unsigned int useconds) {
     // #endif /* SOLARIS */
 }
 
+//----------------------------------------------------------------------
+// HostSeconds
+// 	Return the time of day on the host, in seconds, to time how long
+//	Nachos itself takes to do something (not simulated time).
+//----------------------------------------------------------------------
+
+double HostSeconds() {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
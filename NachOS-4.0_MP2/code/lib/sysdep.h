@@ -26,6 +26,7 @@ extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);  // rcgood - to avoid spinners.
+extern double HostSeconds();            // host clock, for timing Nachos
 
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
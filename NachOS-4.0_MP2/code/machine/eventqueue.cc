@@ -0,0 +1,180 @@
+// eventqueue.cc
+//	Routines to manage the queue of pending interrupts, kept as a
+//	binary heap.  See eventqueue.h.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "eventqueue.h"
+
+#include "copyright.h"
+#include "debug.h"
+#include "interrupt.h"
+
+//----------------------------------------------------------------------
+// Before
+// 	Return TRUE if event "x" is to occur before event "y": it is due
+//	earlier, or at the same time but was put in the queue first.
+//----------------------------------------------------------------------
+
+static bool
+Before(PendingInterrupt *x, PendingInterrupt *y) {
+    if (x->when != y->when)
+        return x->when < y->when;
+    return x->order < y->order;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::EventQueue
+// 	Initialize an empty queue, with room for a few events.
+//----------------------------------------------------------------------
+
+EventQueue::EventQueue() {
+    size = 16;
+    heap = new PendingInterrupt *[size];
+    numEvents = 0;
+    numInserted = 0;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::~EventQueue
+// 	De-allocate the queue.  The events in it belong to the caller.
+//----------------------------------------------------------------------
+
+EventQueue::~EventQueue() {
+    delete[] heap;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Place
+// 	Put "event" at position "i" of the heap, and remember where it
+//	is, so it can be taken out if it is cancelled.
+//----------------------------------------------------------------------
+
+void EventQueue::Place(int i, PendingInterrupt *event) {
+    heap[i] = event;
+    event->heapIndex = i;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::SiftUp
+// 	Move the event at heap[i] towards the front, past every event it
+//	is to occur before.
+//----------------------------------------------------------------------
+
+void EventQueue::SiftUp(int i) {
+    PendingInterrupt *event = heap[i];
+
+    while (i > 0 && Before(event, heap[(i - 1) / 2])) {
+        Place(i, heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    Place(i, event);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::SiftDown
+// 	Move the event at heap[i] towards the back, past every event that
+//	is to occur before it.
+//----------------------------------------------------------------------
+
+void EventQueue::SiftDown(int i) {
+    PendingInterrupt *event = heap[i];
+    int child;
+
+    for (;;) {
+        child = 2 * i + 1;
+        if (child >= numEvents)
+            break;
+        if (child + 1 < numEvents && Before(heap[child + 1], heap[child]))
+            child++;
+        if (!Before(heap[child], event))
+            break;
+        Place(i, heap[child]);
+        i = child;
+    }
+    Place(i, event);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Insert
+// 	Put "event" in the queue, making the heap bigger if it is full.
+//----------------------------------------------------------------------
+
+void EventQueue::Insert(PendingInterrupt *event) {
+    if (numEvents == size) {
+        PendingInterrupt **bigger = new PendingInterrupt *[2 * size];
+
+        for (int i = 0; i < numEvents; i++)
+            bigger[i] = heap[i];
+        delete[] heap;
+        heap = bigger;
+        size *= 2;
+    }
+    event->order = numInserted++;
+    heap[numEvents] = event;
+    numEvents++;
+    SiftUp(numEvents - 1);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::RemoveFront
+// 	Take the event that is to occur first out of the queue, and
+//	return it; NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+PendingInterrupt *EventQueue::RemoveFront() {
+    PendingInterrupt *first;
+
+    if (numEvents == 0)
+        return NULL;
+    first = heap[0];
+    Remove(first);
+    return first;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Remove
+// 	Take "event", which must be in the queue, out of it.  The last
+//	event in the heap takes its place, and is moved up or down to
+//	where it belongs.
+//----------------------------------------------------------------------
+
+void EventQueue::Remove(PendingInterrupt *event) {
+    int i = event->heapIndex;
+
+    ASSERT(i >= 0 && i < numEvents && heap[i] == event);
+    event->heapIndex = -1;
+    numEvents--;
+    if (i == numEvents)
+        return;  // it was the last one
+    Place(i, heap[numEvents]);
+    if (i > 0 && Before(heap[i], heap[(i - 1) / 2]))
+        SiftUp(i);
+    else
+        SiftDown(i);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Apply
+// 	Call "func" on every event in the queue, in the order they are to
+//	occur.  The heap is not in that order, so a sorted copy is made;
+//	this is only used for debugging.
+//----------------------------------------------------------------------
+
+void EventQueue::Apply(void (*func)(PendingInterrupt *)) {
+    PendingInterrupt **sorted = new PendingInterrupt *[numEvents + 1];
+    int i, j;
+
+    for (i = 0; i < numEvents; i++) {  // insertion sort
+        for (j = i; j > 0 && Before(heap[i], sorted[j - 1]); j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = heap[i];
+    }
+    for (i = 0; i < numEvents; i++)
+        (*func)(sorted[i]);
+    delete[] sorted;
+}
@@ -0,0 +1,64 @@
+// eventqueue.h
+//	Data structures for the queue of hardware interrupts that are
+//	scheduled to occur in the future (see interrupt.h).
+//
+//	The queue is a binary heap, ordered by when each interrupt is to
+//	occur, and among interrupts due at the same time, by when they
+//	were put in the queue.  Putting an interrupt in, taking the next
+//	one out, or taking out one that was cancelled take time
+//	logarithmic in the number of interrupts pending; finding the
+//	next one takes constant time.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class PendingInterrupt;
+
+// The following class defines the queue of pending interrupts.
+
+class EventQueue {
+   public:
+    EventQueue();   // Initialize an empty queue
+    ~EventQueue();  // De-allocate the queue; the interrupts
+                    // still in it are not deleted
+
+    void Insert(PendingInterrupt *event);
+    // Put "event" in the queue
+    PendingInterrupt *Front() { return (numEvents == 0) ? NULL : heap[0]; }
+    // The event to occur first, or NULL
+    PendingInterrupt *RemoveFront();  // Take the first event out
+    void Remove(PendingInterrupt *event);
+    // Take "event" out, wherever it is
+
+    bool IsEmpty() { return numEvents == 0; }
+    int NumEvents() { return numEvents; }
+
+    void Apply(void (*func)(PendingInterrupt *));
+    // Call "func" on each event, in the
+    // order they are to occur
+
+   private:
+    PendingInterrupt **heap;  // heap[0] is the first to occur, and
+                              // heap[i] occurs before heap[2i + 1]
+                              // and heap[2i + 2]
+    int numEvents;            // events in the heap
+    int size;                 // room in "heap"
+    int numInserted;          // events ever put in, to order the
+                              // ones due at the same time
+
+    void Place(int i, PendingInterrupt *event);
+    // Put "event" at heap[i]
+    void SiftUp(int i);    // Move heap[i] up to its place
+    void SiftDown(int i);  // Move heap[i] down to its place
+};
+
+#endif  // EVENTQUEUE_H
@@ -23,7 +23,9 @@
 #include "interrupt.h"
 
 #include "copyright.h"
+#include "frametable.h"
 #include "main.h"
+#include "tlbmgr.h"
 
 // String definitions for debugging messages
 
@@ -47,22 +49,8 @@ PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt,
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
-}
-
-//----------------------------------------------------------------------
-// PendingCompare
-//	Compare to interrupts based on which should occur first.
-//----------------------------------------------------------------------
-
-static int
-PendingCompare(PendingInterrupt *x, PendingInterrupt *y) {
-    if (x->when < y->when) {
-        return -1;
-    } else if (x->when > y->when) {
-        return 1;
-    } else {
-        return 0;
-    }
+    order = 0;
+    heapIndex = -1;  // not in the queue yet
 }
 
 //----------------------------------------------------------------------
@@ -74,7 +62,9 @@ PendingCompare(PendingInterrupt *x, PendingInterrupt *y) {
 
 Interrupt::Interrupt() {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new EventQueue();
+    nextDue = -1;
+    traceInt = debug->IsEnabled(dbgInt);
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -141,6 +131,10 @@ Interrupt::SetLevel(IntStatus now) {
 //	Two things can cause OneTick to be called:
 //		interrupts are re-enabled
 //		a user instruction is executed
+//
+//	Since this happens on every tick, the time of the first pending
+//	interrupt is kept in "nextDue", and nothing else is done until
+//	it comes.
 //----------------------------------------------------------------------
 void Interrupt::OneTick() {
     MachineStatus oldStatus = status;
@@ -156,6 +150,11 @@ void Interrupt::OneTick() {
     }
     DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
+    // the usual case: nothing to do until the next interrupt is due
+    if ((nextDue == -1 || nextDue > stats->totalTicks) && !yieldOnReturn &&
+        !traceInt)
+        return;
+
     // check any pending interrupts are now ready to fire
     ChangeLevel(IntOn, IntOff);  // first, turn off interrupts
                                  // (interrupt handlers run with
@@ -231,6 +230,10 @@ void Interrupt::Halt() {
     cout << "This is halt\n";
     kernel->stats->Print();
 #endif
+    if (kernel->frameStats)
+        kernel->frameTable->Print();
+    if (kernel->tlbManager != NULL)
+        kernel->tlbManager->Print();
     delete kernel;  // Never returns.
 }
 /*
@@ -276,7 +279,8 @@ Interrupt::CloseFile(OpenFileId id)
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it in the event queue, and return it, so
+//	the device can cancel it.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -286,7 +290,7 @@ Interrupt::CloseFile(OpenFileId id)
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
-void Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type) {
+PendingInterrupt *Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type) {
     int when = kernel->stats->totalTicks + fromNow;
     PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
 
@@ -294,6 +298,24 @@ void Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type) {
     ASSERT(fromNow > 0);
 
     pending->Insert(toOccur);
+    nextDue = pending->Front()->when;
+    return toOccur;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take an interrupt returned by Schedule out of the queue, so it
+//	never occurs.  It must not have occurred yet, since it is deleted
+//	once it has.
+//
+//	"which" -- the interrupt to cancel
+//----------------------------------------------------------------------
+
+void Interrupt::Cancel(PendingInterrupt *which) {
+    DEBUG(dbgInt, "Cancelling interrupt handler the " << intTypeNames[which->type] << " at time = " << which->when);
+    pending->Remove(which);
+    delete which;
+    nextDue = pending->IsEmpty() ? -1 : pending->Front()->when;
 }
 
 //----------------------------------------------------------------------
@@ -342,6 +364,7 @@ bool Interrupt::CheckIfDue(bool advanceClock) {
     inHandler = TRUE;
     do {
         next = pending->RemoveFront();  // pull interrupt off list
+        nextDue = pending->IsEmpty() ? -1 : pending->Front()->when;
         DEBUG(dbgTraCode, "In Interrupt::CheckIfDue, into callOnInterrupt->CallBack, " << stats->totalTicks);
         next->callOnInterrupt->CallBack();  // call the interrupt handler
         DEBUG(dbgTraCode, "In Interrupt::CheckIfDue, return from callOnInterrupt->CallBack, " << stats->totalTicks);
@@ -376,3 +399,86 @@ void Interrupt::DumpState() {
     pending->Apply(PrintPending);
     cout << "\nEnd of pending interrupts\n";
 }
+
+// The following class defines an alarm used by Interrupt::SelfTest.  It
+// checks that it goes off when it was due, and after every alarm due
+// before it.
+
+static int alarmsFired;        // alarms that have gone off so far
+static int lastWhen, lastNum;  // the last one to go off
+
+class TestAlarm : public CallBackObj {
+   public:
+    TestAlarm(int n, int t) {
+        number = n;
+        when = t;
+        cancelled = FALSE;
+    }
+    void CallBack();
+
+    int number;      // alarms of the same time go off by number
+    int when;        // when it is due
+    bool cancelled;  // it must not go off
+};
+
+void TestAlarm::CallBack() {
+    int now = kernel->stats->totalTicks;
+
+    ASSERT(!cancelled);
+    ASSERT(when <= now && now < when + SystemTick);
+    ASSERT(when > lastWhen || (when == lastWhen && number > lastNum));
+    lastWhen = when;
+    lastNum = number;
+    alarmsFired++;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SelfTest
+// 	Stress the queue of pending interrupts: schedule "numAlarms"
+//	alarms at random times, cancel every third one, and advance time
+//	until the rest have gone off, each at its time and in order.
+//	Print how long (on the host) scheduling and cancelling took, and
+//	how long running the clock until the last one went off took.
+//	Called with interrupts enabled, before any user program runs.
+//----------------------------------------------------------------------
+
+void Interrupt::SelfTest(int numAlarms) {
+    TestAlarm **alarms = new TestAlarm *[numAlarms];
+    PendingInterrupt **scheduled = new PendingInterrupt *[numAlarms];
+    int numCancelled = 0;
+    int i, fromNow, startTicks;
+    double start, scheduleTime, fireTime;
+
+    ASSERT(level == IntOn);
+    alarmsFired = 0;
+    lastWhen = lastNum = -1;
+    start = HostSeconds();
+    for (i = 0; i < numAlarms; i++) {
+        fromNow = 1 + RandomNumber() % (numAlarms * SystemTick);
+        alarms[i] = new TestAlarm(i, kernel->stats->totalTicks + fromNow);
+        scheduled[i] = Schedule(alarms[i], fromNow, TimerInt);
+    }
+    for (i = 0; i < numAlarms; i += 3) {
+        alarms[i]->cancelled = TRUE;
+        Cancel(scheduled[i]);
+        numCancelled++;
+    }
+    scheduleTime = HostSeconds() - start;
+
+    start = HostSeconds();
+    startTicks = kernel->stats->totalTicks;
+    while (alarmsFired < numAlarms - numCancelled)
+        OneTick();
+    fireTime = HostSeconds() - start;
+
+    cout << "Interrupt queue test: " << numAlarms << " alarms, "
+         << numCancelled << " cancelled, " << alarmsFired
+         << " went off in order\n";
+    cout << "Schedule and cancel: " << scheduleTime * 1000 << " ms; "
+         << kernel->stats->totalTicks - startTicks << " ticks until the last: "
+         << fireTime * 1000 << " ms\n";
+    for (i = 0; i < numAlarms; i++)
+        delete alarms[i];
+    delete[] alarms;
+    delete[] scheduled;
+}
@@ -35,6 +35,7 @@
 
 #include "callback.h"
 #include "copyright.h"
+#include "eventqueue.h"
 #include "list.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
@@ -75,6 +76,9 @@ class PendingInterrupt {
 
     int when;      // When the interrupt is supposed to fire
     IntType type;  // for debugging
+
+    int order;      // for the event queue: how many interrupts
+    int heapIndex;  // were scheduled before it, and where it is
 };
 
 // The following class defines the data structures for the simulation
@@ -125,18 +129,27 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(CallBackObj *callTo, int when, IntType type);
+    PendingInterrupt *Schedule(CallBackObj *callTo, int when, IntType type);
     // Schedule an interrupt to occur
     // at time "when".  This is called
     // by the hardware device simulators.
+    void Cancel(PendingInterrupt *which);
+    // Make an interrupt that has not
+    // occurred yet never occur
 
     void OneTick();  // Advance simulated time
+    int NextDue() { return nextDue; }
+    // When the next interrupt is scheduled
+    // to occur, or -1 if none is
+
+    void SelfTest(int numAlarms);  // Test the queue of interrupts
 
    private:
     IntStatus level;  // are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;
-    // the list of interrupts scheduled
-    // to occur in the future
+    EventQueue *pending;  // the interrupts scheduled
+                          // to occur in the future
+    int nextDue;          // when the first of them is, or -1
+    bool traceInt;        // are interrupts being traced
     // int writeFileNo;            //UNIX file emulating the display
     bool inHandler;  // TRUE if we are running an interrupt handler
     // bool putBusy;               // Is a PrintInt operation in progress
@@ -11,6 +11,7 @@
 
 #include "copyright.h"
 #include "main.h"
+#include "mipsblock.h"
 
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
@@ -49,9 +50,13 @@ static void CheckEndian() {
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"tlbEntries" -- the size of the TLB; if 0, there is none and the
+//		linear page table is used (unless built with USE_TLB)
+//	"mode" -- whether to run instructions one at a time, or a block
+//		at a time
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug) {
+Machine::Machine(bool debug, int tlbEntries, ExecMode mode) {
     int i;
 
     for (i = 0; i < NumTotalRegs; i++)
@@ -59,15 +64,38 @@ Machine::Machine(bool debug) {
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
         mainMemory[i] = 0;
+    decoded = new Instruction[MemorySize / 4];
+    decodedValid = new bool[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+        decodedValid[i] = FALSE;
+    for (i = 0; i < NumPhysPages; i++)
+        pageDecoded[i] = FALSE;
+    execMode = mode;
+    blocks = new Block *[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+        blocks[i] = NULL;
+    pendingTicks = 0;
+    traceAddr = ::debug->IsEnabled(dbgAddr);  // the global, not "debug"
+    for (i = 0; i < 3; i++)
+        lastTlbEntry[i] = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-        tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else  // use linear page table
-    tlb = NULL;
-    pageTable = NULL;
+    if (tlbEntries == 0)
+        tlbEntries = TLBSize;
 #endif
+    if (tlbEntries > 0) {
+        tlb = new TranslationEntry[tlbEntries];
+        tlbLastUse = new int[tlbEntries];
+        for (i = 0; i < tlbEntries; i++) {
+            tlb[i].valid = FALSE;
+            tlbLastUse[i] = 0;
+        }
+    } else {  // use linear page table
+        tlb = NULL;
+        tlbLastUse = NULL;
+    }
+    tlbSize = tlbEntries;
+    asid = 0;
+    pageTable = NULL;
 
     singleStep = debug;
     CheckEndian();
@@ -80,8 +108,35 @@ Machine::Machine(bool debug) {
 
 Machine::~Machine() {
     delete[] mainMemory;
-    if (tlb != NULL)
+    delete[] decoded;
+    delete[] decodedValid;
+    for (int i = 0; i < MemorySize / 4; i++)
+        delete blocks[i];
+    delete[] blocks;
+    if (tlb != NULL) {
         delete[] tlb;
+        delete[] tlbLastUse;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecoded
+// 	Forget the instructions and blocks decoded from physical page
+//	"frame", because what is in it is about to change.  Called on
+//	every store by a user program, so it returns at once if nothing
+//	was decoded from the page.  The blocks are kept to be rebuilt,
+//	since one of them may be running.
+//----------------------------------------------------------------------
+
+void Machine::InvalidateDecoded(int frame) {
+    if (!pageDecoded[frame])
+        return;
+    for (int i = frame * PageSize / 4; i < (frame + 1) * PageSize / 4; i++) {
+        decodedValid[i] = FALSE;
+        if (blocks[i] != NULL)
+            blocks[i]->valid = FALSE;
+    }
+    pageDecoded[frame] = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -97,6 +152,7 @@ Machine::~Machine() {
 void Machine::RaiseException(ExceptionType which, int badVAddr) {
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
     registers[BadVAddrReg] = badVAddr;
+    ChargeTicks();      // the block instructions before this one
     DelayedLoad(0, 0);  // finish anything in progress
     kernel->interrupt->setStatus(SystemMode);
     ExceptionHandler(which);  // interrupts are enabled at this point
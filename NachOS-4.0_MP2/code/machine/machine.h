@@ -10,7 +10,9 @@
 //
 //	In Nachos, user programs are executed one instruction at a time,
 //	by the simulator.  Each memory reference is translated, checked
-//	for errors, etc.
+//	for errors, etc.  An instruction is only decoded the first time it
+//	is run from where it is in physical memory; the decoded copy is
+//	kept until that page of memory is written or given to another page.
 //
 //  DO NOT CHANGE EXCEPT AS NOTED BELOW -- part of the machine emulation
 //
@@ -38,7 +40,8 @@ const int PageSize = 128;  // set the page size equal to
 const int NumPhysPages = 128;
 
 const int MemorySize = (NumPhysPages * PageSize);
-const int TLBSize = 4;  // if there is a TLB, make it small
+const int TLBSize = 4;  // if there is a TLB, make it small;
+                        // the size when built with USE_TLB
 
 enum ExceptionType { NoException,            // Everything ok!
                      SyscallException,       // A program executed a system call.
@@ -60,6 +63,16 @@ enum ExceptionType { NoException,            // Everything ok!
                      NumExceptionTypes
 };
 
+// How user instructions are run: one at a time by the interpreter, or a
+// block at a time (see mipsblock.h), possibly checking each handler
+// against the interpreter.
+
+enum ExecMode { ExecInterpret, ExecBlocks, ExecCheckBlocks };
+
+// The kinds of memory access, for Machine::QuickTranslate.
+
+enum AccessType { ReadAccess, WriteAccess, FetchAccess };
+
 // User program CPU state.  The full set of MIPS registers, plus a few
 // more because we need to be able to start/stop a user program between
 // any two instructions (thus we need to keep track of things like load
@@ -79,6 +92,26 @@ enum ExceptionType { NoException,            // Everything ok!
 
 #define NumTotalRegs 40
 
+// The following class defines an instruction, represented in both
+// 	undecoded binary form
+//      decoded to identify
+//	    operation to do
+//	    registers to act on
+//	    any immediate operand value
+
+class Instruction {
+   public:
+    void Decode();  // decode the binary representation of the instruction
+
+    unsigned int value;  // binary representation of the instruction
+
+    char opCode;      // Type of instruction.  This is NOT the same as the
+                      // opcode field from the instruction: see defs in mips.h
+    char rs, rt, rd;  // Three registers from instruction.
+    int extra;        // Immediate or target or shamt field or offset.
+                      // Immediates are sign-extended.
+};
+
 // The following class defines the simulated host workstation hardware, as
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our
@@ -89,16 +122,19 @@ enum ExceptionType { NoException,            // Everything ok!
 // If we were to implement more of the UNIX system calls, we ought to be
 // able to run Nachos on top of Nachos!
 //
-// The procedures in this class are defined in machine.cc, mipssim.cc, and
-// translate.cc.
+// The procedures in this class are defined in machine.cc, mipssim.cc,
+// mipsblock.cc and translate.cc.
 
-class Instruction;
+class Block;
+class BlockEntry;
 class Interrupt;
 
 class Machine {
    public:
-    Machine(bool debug);  // Initialize the simulation of the hardware
-                          // for running user programs
+    Machine(bool debug, int tlbEntries, ExecMode mode);
+    // Initialize the simulation of the hardware
+    // for running user programs, with a TLB of
+    // "tlbEntries" entries if it is not 0
     ~Machine();           // De-allocate the data structures
 
     // Routines callable by the Nachos kernel
@@ -138,6 +174,11 @@ class Machine {
 
     TranslationEntry *tlb;  // this pointer should be considered
                             // "read-only" to Nachos kernel code
+    int tlbSize;            // number of entries in the TLB
+    int asid;               // only TLB entries tagged with this
+                            // address space are used
+    int *tlbLastUse;        // when each TLB entry was last used, in
+                            // TLB hits, for LRU replacement
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
@@ -147,6 +188,11 @@ class Machine {
     // Read or write 1, 2, or 4 bytes of virtual
     // memory (at addr).  Return FALSE if a
     // correct translation couldn't be found.
+
+    void InvalidateDecoded(int frame);
+    // The contents of physical page "frame"
+    // are changing; forget the instructions
+    // decoded from it
    private:
     // Routines internal to the machine simulation -- DO NOT call these directly
     void DelayedLoad(int nextReg, int nextVal);
@@ -154,6 +200,21 @@ class Machine {
 
     void OneInstruction(Instruction *instr);
     // Run one instruction of a user program.
+    bool Execute(Instruction *instr);
+    // Run the decoded instruction at the PC;
+    // FALSE if it raised an exception
+    bool FetchInstruction(Instruction *instr);
+    // Fetch and decode the instruction at the
+    // PC, or copy it from the decoded cache
+
+    void RunBlock();  // Run the block of instructions at the PC
+    Block *BuildBlock(int physAddr);
+    // Decode the block starting at "physAddr"
+    void CheckHandler(BlockEntry *e);
+    // Run "e" by its handler and by the
+    // interpreter, and compare
+    void ChargeTicks();  // Advance simulated time for the block
+                         // instructions run so far
 
     ExceptionType Translate(int virtAddr, int *physAddr, int size, bool writing);
     // Translate an address, and check for
@@ -161,6 +222,10 @@ class Machine {
     // the translation entry appropriately,
     // and return an exception code if the
     // translation couldn't be completed.
+    bool QuickTranslate(int virtAddr, int *physAddr, AccessType type);
+    // Translate an aligned word address the
+    // way Translate would, when that is simple;
+    // FALSE, with nothing changed, if it is not
 
     void RaiseException(ExceptionType which, int badVAddr);
     // Trap to the Nachos kernel, because of a
@@ -173,6 +238,22 @@ class Machine {
 
     int registers[NumTotalRegs];  // CPU registers, for executing user programs
 
+    Instruction *decoded;          // the decoded instruction in each word
+                                   // of main memory that has been run
+    bool *decodedValid;            // is the word's entry in "decoded" good
+    bool pageDecoded[NumPhysPages];  // does the page have any good entries
+                                     // or blocks
+
+    ExecMode execMode;   // how instructions are run
+    Block **blocks;      // the block starting at each word of main
+                         // memory, or NULL if none was built
+    int pendingTicks;    // instructions of the running block not yet
+                         // charged to simulated time
+
+    bool traceAddr;           // are address translations being traced
+    int lastTlbEntry[3];      // the TLB entry that last translated each
+                              // type of access
+
     bool singleStep;   // drop back into the debugger after each
                        // simulated instruction
     int runUntilTime;  // drop back into the debugger when simulated
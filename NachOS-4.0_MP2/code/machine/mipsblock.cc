@@ -0,0 +1,463 @@
+// mipsblock.cc
+//	Routines to run user programs a block of instructions at a time,
+//	calling a handler bound to each instruction when the block was
+//	built, instead of decoding and dispatching it every time it is
+//	run.  See mipsblock.h.
+//
+//	The handlers must do exactly what Machine::Execute does for the
+//	same instruction; with -bbcheck every handler is checked against
+//	it as it runs.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "mipsblock.h"
+
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+#include "mipssim.h"
+
+//----------------------------------------------------------------------
+// Finish
+// 	Do what the interpreter does after each instruction: the delayed
+//	load left by the instruction before, and advancing the PC.  No
+//	instruction with a handler loads from memory, so none leaves a
+//	delayed load of its own.
+//
+//	"pcAfter" -- where to go after the instruction in the delay slot
+//----------------------------------------------------------------------
+
+static inline void
+Finish(int *r, int pcAfter) {
+    r[r[LoadReg]] = r[LoadValueReg];
+    r[LoadReg] = 0;
+    r[LoadValueReg] = 0;
+    r[0] = 0;
+    r[PrevPCReg] = r[PCReg];
+    r[PCReg] = r[NextPCReg];
+    r[NextPCReg] = pcAfter;
+}
+
+// The address after the delay slot, if there is no jump, and the
+// target of a taken branch.
+#define Sequential(r) ((r)[NextPCReg] + 4)
+#define BranchTarget(r, in) ((r)[NextPCReg] + IndexToAddr((in)->extra))
+
+// The handlers, one for each instruction that only changes registers.
+// The ones that can raise an exception, and the loads and stores, are
+// left to the interpreter.
+
+static void DoADDIU(int *r, Instruction *in) {
+    r[in->rt] = r[in->rs] + in->extra;
+    Finish(r, Sequential(r));
+}
+
+static void DoADDU(int *r, Instruction *in) {
+    r[in->rd] = r[in->rs] + r[in->rt];
+    Finish(r, Sequential(r));
+}
+
+static void DoAND(int *r, Instruction *in) {
+    r[in->rd] = r[in->rs] & r[in->rt];
+    Finish(r, Sequential(r));
+}
+
+static void DoANDI(int *r, Instruction *in) {
+    r[in->rt] = r[in->rs] & (in->extra & 0xffff);
+    Finish(r, Sequential(r));
+}
+
+static void DoLUI(int *r, Instruction *in) {
+    DEBUG(dbgMach, "Executing: LUI r" << in->rt << ", " << in->extra);
+    r[in->rt] = in->extra << 16;
+    Finish(r, Sequential(r));
+}
+
+static void DoMFHI(int *r, Instruction *in) {
+    r[in->rd] = r[HiReg];
+    Finish(r, Sequential(r));
+}
+
+static void DoMFLO(int *r, Instruction *in) {
+    r[in->rd] = r[LoReg];
+    Finish(r, Sequential(r));
+}
+
+static void DoMTHI(int *r, Instruction *in) {
+    r[HiReg] = r[in->rs];
+    Finish(r, Sequential(r));
+}
+
+static void DoMTLO(int *r, Instruction *in) {
+    r[LoReg] = r[in->rs];
+    Finish(r, Sequential(r));
+}
+
+static void DoNOR(int *r, Instruction *in) {
+    r[in->rd] = ~(r[in->rs] | r[in->rt]);
+    Finish(r, Sequential(r));
+}
+
+static void DoOR(int *r, Instruction *in) {
+    r[in->rd] = r[in->rs] | r[in->rt];
+    Finish(r, Sequential(r));
+}
+
+static void DoORI(int *r, Instruction *in) {
+    r[in->rt] = r[in->rs] | (in->extra & 0xffff);
+    Finish(r, Sequential(r));
+}
+
+static void DoXOR(int *r, Instruction *in) {
+    r[in->rd] = r[in->rs] ^ r[in->rt];
+    Finish(r, Sequential(r));
+}
+
+static void DoXORI(int *r, Instruction *in) {
+    r[in->rt] = r[in->rs] ^ (in->extra & 0xffff);
+    Finish(r, Sequential(r));
+}
+
+static void DoSLL(int *r, Instruction *in) {
+    r[in->rd] = r[in->rt] << in->extra;
+    Finish(r, Sequential(r));
+}
+
+static void DoSLLV(int *r, Instruction *in) {
+    r[in->rd] = r[in->rt] << (r[in->rs] & 0x1f);
+    Finish(r, Sequential(r));
+}
+
+static void DoSLT(int *r, Instruction *in) {
+    r[in->rd] = (r[in->rs] < r[in->rt]) ? 1 : 0;
+    Finish(r, Sequential(r));
+}
+
+static void DoSLTI(int *r, Instruction *in) {
+    r[in->rt] = (r[in->rs] < in->extra) ? 1 : 0;
+    Finish(r, Sequential(r));
+}
+
+static void DoSLTIU(int *r, Instruction *in) {
+    r[in->rt] = ((unsigned int)r[in->rs] < (unsigned int)in->extra) ? 1 : 0;
+    Finish(r, Sequential(r));
+}
+
+static void DoSLTU(int *r, Instruction *in) {
+    r[in->rd] = ((unsigned int)r[in->rs] < (unsigned int)r[in->rt]) ? 1 : 0;
+    Finish(r, Sequential(r));
+}
+
+// The interpreter shifts a signed int for SRL and SRLV too, so they
+// are the same as SRA and SRAV here.
+
+static void DoSRA(int *r, Instruction *in) {
+    r[in->rd] = r[in->rt] >> in->extra;
+    Finish(r, Sequential(r));
+}
+
+static void DoSRAV(int *r, Instruction *in) {
+    r[in->rd] = r[in->rt] >> (r[in->rs] & 0x1f);
+    Finish(r, Sequential(r));
+}
+
+static void DoSUBU(int *r, Instruction *in) {
+    r[in->rd] = r[in->rs] - r[in->rt];
+    Finish(r, Sequential(r));
+}
+
+static void DoBEQ(int *r, Instruction *in) {
+    Finish(r, (r[in->rs] == r[in->rt]) ? BranchTarget(r, in) : Sequential(r));
+}
+
+static void DoBNE(int *r, Instruction *in) {
+    Finish(r, (r[in->rs] != r[in->rt]) ? BranchTarget(r, in) : Sequential(r));
+}
+
+static void DoBGEZ(int *r, Instruction *in) {
+    Finish(r, !(r[in->rs] & SIGN_BIT) ? BranchTarget(r, in) : Sequential(r));
+}
+
+static void DoBGEZAL(int *r, Instruction *in) {
+    r[R31] = r[NextPCReg] + 4;
+    DoBGEZ(r, in);
+}
+
+static void DoBGTZ(int *r, Instruction *in) {
+    Finish(r, (r[in->rs] > 0) ? BranchTarget(r, in) : Sequential(r));
+}
+
+static void DoBLEZ(int *r, Instruction *in) {
+    Finish(r, (r[in->rs] <= 0) ? BranchTarget(r, in) : Sequential(r));
+}
+
+static void DoBLTZ(int *r, Instruction *in) {
+    Finish(r, (r[in->rs] & SIGN_BIT) ? BranchTarget(r, in) : Sequential(r));
+}
+
+static void DoBLTZAL(int *r, Instruction *in) {
+    r[R31] = r[NextPCReg] + 4;
+    DoBLTZ(r, in);
+}
+
+static void DoJ(int *r, Instruction *in) {
+    Finish(r, (Sequential(r) & 0xf0000000) | IndexToAddr(in->extra));
+}
+
+static void DoJAL(int *r, Instruction *in) {
+    r[R31] = r[NextPCReg] + 4;
+    DoJ(r, in);
+}
+
+static void DoJR(int *r, Instruction *in) {
+    Finish(r, r[in->rs]);
+}
+
+static void DoJALR(int *r, Instruction *in) {
+    r[in->rd] = r[NextPCReg] + 4;
+    DoJR(r, in);
+}
+
+//----------------------------------------------------------------------
+// HandlerFor
+// 	Return the handler for instructions with "opCode", or NULL if
+//	they are to be run by the interpreter.
+//----------------------------------------------------------------------
+
+static OpHandler
+HandlerFor(int opCode) {
+    switch (opCode) {
+        case OP_ADDIU:
+            return DoADDIU;
+        case OP_ADDU:
+            return DoADDU;
+        case OP_AND:
+            return DoAND;
+        case OP_ANDI:
+            return DoANDI;
+        case OP_LUI:
+            return DoLUI;
+        case OP_MFHI:
+            return DoMFHI;
+        case OP_MFLO:
+            return DoMFLO;
+        case OP_MTHI:
+            return DoMTHI;
+        case OP_MTLO:
+            return DoMTLO;
+        case OP_NOR:
+            return DoNOR;
+        case OP_OR:
+            return DoOR;
+        case OP_ORI:
+            return DoORI;
+        case OP_XOR:
+            return DoXOR;
+        case OP_XORI:
+            return DoXORI;
+        case OP_SLL:
+            return DoSLL;
+        case OP_SLLV:
+            return DoSLLV;
+        case OP_SLT:
+            return DoSLT;
+        case OP_SLTI:
+            return DoSLTI;
+        case OP_SLTIU:
+            return DoSLTIU;
+        case OP_SLTU:
+            return DoSLTU;
+        case OP_SRA:
+        case OP_SRL:
+            return DoSRA;
+        case OP_SRAV:
+        case OP_SRLV:
+            return DoSRAV;
+        case OP_SUBU:
+            return DoSUBU;
+        case OP_BEQ:
+            return DoBEQ;
+        case OP_BNE:
+            return DoBNE;
+        case OP_BGEZ:
+            return DoBGEZ;
+        case OP_BGEZAL:
+            return DoBGEZAL;
+        case OP_BGTZ:
+            return DoBGTZ;
+        case OP_BLEZ:
+            return DoBLEZ;
+        case OP_BLTZ:
+            return DoBLTZ;
+        case OP_BLTZAL:
+            return DoBLTZAL;
+        case OP_J:
+            return DoJ;
+        case OP_JAL:
+            return DoJAL;
+        case OP_JR:
+            return DoJR;
+        case OP_JALR:
+            return DoJALR;
+        default:
+            return NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::BuildBlock
+// 	Decode the block of instructions starting at physical address
+//	"physAddr", reusing the old block there if there is one, and
+//	return it.  The block ends at the end of the page, after a
+//	system call, or after the delay slot of an unconditional jump.
+//----------------------------------------------------------------------
+
+Block *Machine::BuildBlock(int physAddr) {
+    int word = physAddr / 4;
+    int end = (physAddr / PageSize + 1) * (PageSize / 4);  // first word
+                                                            // of the next page
+    Block *block = blocks[word];
+    bool delaySlot = FALSE;
+    int n = 0;
+
+    if (block == NULL) {
+        block = new Block;
+        blocks[word] = block;
+    }
+    while (word + n < end) {
+        Instruction *instr = &block->entry[n].instr;
+
+        instr->value = WordToHost(*(unsigned int *)&mainMemory[(word + n) * 4]);
+        instr->Decode();
+        block->entry[n].handler = HandlerFor(instr->opCode);
+        n++;
+        if (delaySlot || instr->opCode == OP_SYSCALL)
+            break;
+        delaySlot = (instr->opCode == OP_J || instr->opCode == OP_JAL ||
+                     instr->opCode == OP_JR || instr->opCode == OP_JALR);
+    }
+    DEBUG(dbgMach, "Built block of " << n << " instructions at " << physAddr);
+    block->length = n;
+    block->valid = TRUE;
+    pageDecoded[physAddr / PageSize] = TRUE;
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Run the block of instructions at the PC, building it first if
+//	need be, and advance simulated time as if they had been run
+//	one at a time.
+//
+//	The block is left when the PC goes somewhere else, an exception
+//	is raised, or a store changes the block's page.  So that no
+//	interrupt happens at a different time, no more instructions are
+//	run than there are ticks until the next interrupt is due; the
+//	ticks of all but the last are added up, and the last one is a
+//	real Interrupt::OneTick, which may run the interrupt.  If an
+//	exception is raised, RaiseException charges the ticks of the
+//	instructions before it, before the kernel sees the time.
+//
+//	The PC is translated once for the block; no page can be taken
+//	away without an exception.  With a TLB, the PC is still looked
+//	up for each instruction, for the TLB statistics and LRU order.
+//----------------------------------------------------------------------
+
+void Machine::RunBlock() {
+    ExceptionType exception;
+    int startPC = registers[PCReg];
+    int physAddr, limit, due, i;
+    Block *block;
+
+    if (!QuickTranslate(startPC, &physAddr, FetchAccess)) {
+        exception = Translate(startPC, &physAddr, 4, FALSE);
+        if (exception != NoException) {
+            RaiseException(exception, startPC);
+            kernel->interrupt->OneTick();
+            return;
+        }
+    }
+    block = blocks[physAddr / 4];
+    if (block == NULL || !block->valid)
+        block = BuildBlock(physAddr);
+
+    limit = block->length;
+    due = kernel->interrupt->NextDue();
+    if (due != -1) {
+        int room = (due - kernel->stats->totalTicks - 1) / UserTick + 1;
+
+        if (room < limit)
+            limit = (room < 1) ? 1 : room;
+    }
+
+    for (i = 0;;) {
+        BlockEntry *e = &block->entry[i];
+
+        if (e->handler == NULL) {
+            if (!Execute(&e->instr))
+                break;  // exception occurred
+        } else if (execMode == ExecCheckBlocks) {
+            CheckHandler(e);
+        } else {
+            (*e->handler)(registers, &e->instr);
+        }
+        i++;
+        if (i == limit || !block->valid || registers[PCReg] != startPC + 4 * i)
+            break;
+        if (tlb != NULL && !QuickTranslate(registers[PCReg], &physAddr, FetchAccess)) {
+            exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+            ASSERT(exception == NoException);
+        }
+        pendingTicks++;
+    }
+    ChargeTicks();
+    kernel->interrupt->OneTick();
+}
+
+//----------------------------------------------------------------------
+// Machine::ChargeTicks
+// 	Advance simulated time for the instructions of the running block
+//	that have not been charged for yet.  No interrupt can be due.
+//----------------------------------------------------------------------
+
+void Machine::ChargeTicks() {
+    if (pendingTicks == 0)
+        return;
+    kernel->stats->totalTicks += pendingTicks * UserTick;
+    kernel->stats->userTicks += pendingTicks * UserTick;
+    pendingTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::CheckHandler
+// 	Run the instruction of block entry "e" by its handler, then again
+//	from the same registers by the interpreter, and stop Nachos if the
+//	registers do not come out the same.  Handlers do not touch memory,
+//	so running the instruction twice does no harm.
+//----------------------------------------------------------------------
+
+void Machine::CheckHandler(BlockEntry *e) {
+    int before[NumTotalRegs], after[NumTotalRegs];
+    bool ok;
+
+    bcopy(registers, before, sizeof(registers));
+    (*e->handler)(registers, &e->instr);
+    bcopy(registers, after, sizeof(registers));
+    bcopy(before, registers, sizeof(registers));
+    ok = Execute(&e->instr);
+    ASSERT(ok);
+
+    for (int i = 0; i < NumTotalRegs; i++) {
+        if (registers[i] != after[i]) {
+            cerr << "Block handler for \"" << opStrings[e->instr.opCode].format
+                 << "\" at PC " << before[PCReg] << " set register " << i
+                 << " to " << after[i] << ", the interpreter to "
+                 << registers[i] << "\n";
+            ASSERTNOTREACHED();
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// mipsblock.h
+//	Data structures for running user programs a block of instructions
+//	at a time, instead of one instruction at a time (see mipssim.cc).
+//
+//	A block is the run of instructions starting at some word of main
+//	memory, up to the end of its page, and ending early after an
+//	unconditional jump and its delay slot, or at a system call.  Each
+//	instruction is decoded once, when the block is built, and bound
+//	to a handler that does just that operation; instructions that can
+//	touch memory or raise an exception are bound to no handler, and
+//	are run by the usual interpreter.  A conditional branch does not
+//	end the block: if it is not taken, the block goes on.
+//
+//	The block is run until the PC leaves it, an exception happens, or
+//	the next hardware interrupt would be due.  Simulated time is only
+//	advanced once per block, but by the same amount, and interrupts
+//	happen at the same times, as if each instruction were run alone.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MIPSBLOCK_H
+#define MIPSBLOCK_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define MaxBlockLength (PageSize / 4)  // a block never crosses a page
+
+// A handler runs one decoded instruction on the registers, and
+// advances the PC past it.
+
+typedef void (*OpHandler)(int *registers, Instruction *instr);
+
+// The following class defines one instruction of a block.
+
+class BlockEntry {
+   public:
+    OpHandler handler;  // NULL if the interpreter must run it
+    Instruction instr;  // the instruction, decoded
+};
+
+// The following class defines a block of instructions.
+
+class Block {
+   public:
+    bool valid;   // FALSE once its page of memory changes
+    int length;   // instructions in the block
+    BlockEntry entry[MaxBlockLength];
+};
+
+#endif  // MIPSBLOCK_H
@@ -23,31 +23,14 @@
 
 static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr);
 
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
-
-class Instruction {
-   public:
-    void Decode();  // decode the binary representation of the instruction
-
-    unsigned int value;  // binary representation of the instruction
-
-    char opCode;      // Type of instruction.  This is NOT the same as the
-                      // opcode field from the instruction: see defs in mips.h
-    char rs, rt, rd;  // Three registers from instruction.
-    int extra;        // Immediate or target or shamt field or offset.
-                      // Immediates are sign-extended.
-};
-
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
 //	Called by the kernel when the program starts up; never returns.
 //
+//	Instructions are run a block at a time if the kernel asked for
+//	it, unless they are being traced or single-stepped.
+//
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
 //----------------------------------------------------------------------
@@ -58,6 +41,10 @@ void Machine::Run() {
         cout << ", at time: " << kernel->stats->totalTicks << "\n";
     }
     kernel->interrupt->setStatus(UserMode);
+    if (execMode != ExecInterpret && !singleStep && !debug->IsEnabled('m')) {
+        for (;;)
+            RunBlock();  // charges the ticks itself
+    }
     for (;;) {
         DEBUG(dbgTraCode, "In Machine::Run(), into OneInstruction "
                               << "== Tick " << kernel->stats->totalTicks << " ==");
@@ -120,20 +107,9 @@ TypeToReg(RegType reg, Instruction *instr) {
 //----------------------------------------------------------------------
 
 void Machine::OneInstruction(Instruction *instr) {
-#ifdef SIM_FIX
-    int byte;  // described in Kane for LWL,LWR,...
-#endif
-
-    int raw;
-    int nextLoadReg = 0;
-    int nextLoadValue = 0;  // record delayed load operation, to apply
-                            // in the future
-
     // Fetch instruction
-    if (!ReadMem(registers[PCReg], 4, &raw))
+    if (!FetchInstruction(instr))
         return;  // exception occurred
-    instr->value = raw;
-    instr->Decode();
 
     if (debug->IsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
@@ -145,6 +121,25 @@ void Machine::OneInstruction(Instruction *instr) {
                 TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
         cout << "\t" << buf << "\n";
     }
+    Execute(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::Execute
+// 	Run the decoded instruction "instr", which is the one at the PC,
+//	and advance the PC past it.  Return FALSE if it raised an
+//	exception; the kernel has then handled it, and the PC is where
+//	the kernel left it.
+//----------------------------------------------------------------------
+
+bool Machine::Execute(Instruction *instr) {
+#ifdef SIM_FIX
+    int byte;  // described in Kane for LWL,LWR,...
+#endif
+
+    int nextLoadReg = 0;
+    int nextLoadValue = 0;  // record delayed load operation, to apply
+                            // in the future
 
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
@@ -158,7 +153,7 @@ void Machine::OneInstruction(Instruction *instr) {
             if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
                 ((registers[instr->rs] ^ sum) & SIGN_BIT)) {
                 RaiseException(OverflowException, 0);
-                return;
+                return FALSE;
             }
             registers[instr->rd] = sum;
             break;
@@ -168,7 +163,7 @@ void Machine::OneInstruction(Instruction *instr) {
             if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
                 ((instr->extra ^ sum) & SIGN_BIT)) {
                 RaiseException(OverflowException, 0);
-                return;
+                return FALSE;
             }
             registers[instr->rt] = sum;
             break;
@@ -263,7 +258,7 @@ void Machine::OneInstruction(Instruction *instr) {
         case OP_LBU:
             tmp = registers[instr->rs] + instr->extra;
             if (!ReadMem(tmp, 1, &value))
-                return;
+                return FALSE;
 
             if ((value & 0x80) && (instr->opCode == OP_LB))
                 value |= 0xffffff00;
@@ -278,10 +273,10 @@ void Machine::OneInstruction(Instruction *instr) {
             tmp = registers[instr->rs] + instr->extra;
             if (tmp & 0x1) {
                 RaiseException(AddressErrorException, tmp);
-                return;
+                return FALSE;
             }
             if (!ReadMem(tmp, 2, &value))
-                return;
+                return FALSE;
 
             if ((value & 0x8000) && (instr->opCode == OP_LH))
                 value |= 0xffff0000;
@@ -300,10 +295,10 @@ void Machine::OneInstruction(Instruction *instr) {
             tmp = registers[instr->rs] + instr->extra;
             if (tmp & 0x3) {
                 RaiseException(AddressErrorException, tmp);
-                return;
+                return FALSE;
             }
             if (!ReadMem(tmp, 4, &value))
-                return;
+                return FALSE;
             nextLoadReg = instr->rt;
             nextLoadValue = value;
             break;
@@ -323,7 +318,7 @@ void Machine::OneInstruction(Instruction *instr) {
             // DEBUG('P', "Addr 0x%X\n",tmp-byte);
 
             if (!ReadMem(tmp - byte, 4, &value))
-                return;
+                return FALSE;
 #else
             // ReadMem assumes all 4 byte requests are aligned on an even
             // word boundary.  Also, the little endian/big endian swap code would
@@ -331,7 +326,7 @@ void Machine::OneInstruction(Instruction *instr) {
             ASSERT((tmp & 0x3) == 0);
 
             if (!ReadMem(tmp, 4, &value))
-                return;
+                return FALSE;
 #endif
 
             if (registers[LoadReg] == instr->rt)
@@ -375,7 +370,7 @@ void Machine::OneInstruction(Instruction *instr) {
             // DEBUG('P', "Addr 0x%X\n",tmp-byte);
 
             if (!ReadMem(tmp - byte, 4, &value))
-                return;
+                return FALSE;
 #else
             // ReadMem assumes all 4 byte requests are aligned on an even
             // word boundary.  Also, the little endian/big endian swap code would
@@ -383,7 +378,7 @@ void Machine::OneInstruction(Instruction *instr) {
             ASSERT((tmp & 0x3) == 0);
 
             if (!ReadMem(tmp, 4, &value))
-                return;
+                return FALSE;
 #endif
 
             if (registers[LoadReg] == instr->rt)
@@ -455,12 +450,12 @@ void Machine::OneInstruction(Instruction *instr) {
 
         case OP_SB:
             if (!WriteMem((unsigned)(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
-                return;
+                return FALSE;
             break;
 
         case OP_SH:
             if (!WriteMem((unsigned)(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
-                return;
+                return FALSE;
             break;
 
         case OP_SLL:
@@ -529,7 +524,7 @@ void Machine::OneInstruction(Instruction *instr) {
             if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
                 ((registers[instr->rs] ^ diff) & SIGN_BIT)) {
                 RaiseException(OverflowException, 0);
-                return;
+                return FALSE;
             }
             registers[instr->rd] = diff;
             break;
@@ -540,7 +535,7 @@ void Machine::OneInstruction(Instruction *instr) {
 
         case OP_SW:
             if (!WriteMem((unsigned)(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
-                return;
+                return FALSE;
             break;
 
         case OP_SWL:
@@ -556,7 +551,7 @@ void Machine::OneInstruction(Instruction *instr) {
             byte = tmp & 0x3;
             // DEBUG('P', "Addr 0x%X\n",tmp-byte);
             if (!ReadMem(tmp - byte, 4, &value))
-                return;
+                return FALSE;
 
                 // DEBUG('P', "Value 0x%X\n",value);
 #else
@@ -566,7 +561,7 @@ void Machine::OneInstruction(Instruction *instr) {
             ASSERT((tmp & 0x3) == 0);
 
             if (!ReadMem((tmp & ~0x3), 4, &value))
-                return;
+                return FALSE;
 #endif
 
 #ifdef SIM_FIX
@@ -593,12 +588,12 @@ void Machine::OneInstruction(Instruction *instr) {
             }
 #ifndef SIM_FIX
             if (!WriteMem((tmp & ~0x3), 4, value))
-                return;
+                return FALSE;
 #else
             // DEBUG('P', "Value 0x%X\n",value);
 
             if (!WriteMem((tmp - byte), 4, value))
-                return;
+                return FALSE;
 #endif  // SIM_FIX
             break;
 
@@ -611,7 +606,7 @@ void Machine::OneInstruction(Instruction *instr) {
             ASSERT((tmp & 0x3) == 0);
 
             if (!ReadMem((tmp & ~0x3), 4, &value))
-                return;
+                return FALSE;
 #else
             // The only difference between this code and the BIG ENDIAN code
             // is that the ReadMem call is guaranteed an aligned access as
@@ -624,7 +619,7 @@ void Machine::OneInstruction(Instruction *instr) {
             // DEBUG('P', "Addr 0x%X\n",tmp-byte);
 
             if (!ReadMem(tmp - byte, 4, &value))
-                return;
+                return FALSE;
                 // DEBUG('P', "Value 0x%X\n",value);
 #endif  // SIM_FIX
 
@@ -650,12 +645,12 @@ void Machine::OneInstruction(Instruction *instr) {
 
 #ifndef SIM_FIX
             if (!WriteMem((tmp & ~0x3), 4, value))
-                return;
+                return FALSE;
 #else
             // DEBUG('P', "Value 0x%X\n",value);
 
             if (!WriteMem((tmp - byte), 4, value))
-                return;
+                return FALSE;
 #endif  // SIM_FIX
 
             break;
@@ -663,7 +658,7 @@ void Machine::OneInstruction(Instruction *instr) {
         case OP_SYSCALL:
             DEBUG(dbgTraCode, "In Machine::OneInstruction, RaiseException(SyscallException, 0), " << kernel->stats->totalTicks);
             RaiseException(SyscallException, 0);
-            return;
+            return FALSE;
 
         case OP_XOR:
             registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
@@ -676,7 +671,7 @@ void Machine::OneInstruction(Instruction *instr) {
         case OP_RES:
         case OP_UNIMP:
             RaiseException(IllegalInstrException, 0);
-            return;
+            return FALSE;
 
         default:
             ASSERT(FALSE);
@@ -692,6 +687,40 @@ void Machine::OneInstruction(Instruction *instr) {
                                               // are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Put the instruction at the PC, decoded, in "instr".  The PC is
+//	translated like any other address read, so page faults, use bits
+//	and the TLB are as before; but the instruction is only read from
+//	memory and decoded the first time it is run from where it is in
+//	physical memory.  Return FALSE if an exception occurred.
+//----------------------------------------------------------------------
+
+bool Machine::FetchInstruction(Instruction *instr) {
+    ExceptionType exception;
+    int physAddr, word;
+
+    if (!QuickTranslate(registers[PCReg], &physAddr, FetchAccess)) {
+        DEBUG(dbgAddr, "Fetching VA " << registers[PCReg]);
+
+        exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+        if (exception != NoException) {
+            RaiseException(exception, registers[PCReg]);
+            return FALSE;
+        }
+    }
+    word = physAddr / 4;
+    if (!decodedValid[word]) {
+        decoded[word].value = WordToHost(*(unsigned int *)&mainMemory[physAddr]);
+        decoded[word].Decode();
+        decodedValid[word] = TRUE;
+        pageDecoded[physAddr / PageSize] = TRUE;
+    }
+    *instr = decoded[word];
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
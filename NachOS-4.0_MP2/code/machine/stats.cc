@@ -22,6 +22,9 @@ Statistics::Statistics() {
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSwapReads = numSwapWrites = 0;
+    numSharedFaults = numCopyOnWrites = numZeroFills = 0;
+    numTLBHits = numTLBMisses = 0;
 }
 
 //----------------------------------------------------------------------
@@ -37,7 +40,16 @@ void Statistics::Print() {
     cout << ", writes " << numDiskWrites << "\n";
     cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
-    cout << "Paging: faults " << numPageFaults << "\n";
+    cout << "Paging: faults " << numPageFaults;
+    cout << ", swap reads " << numSwapReads;
+    cout << ", swap writes " << numSwapWrites;
+    cout << ", shared " << numSharedFaults;
+    cout << ", copied on write " << numCopyOnWrites;
+    cout << ", zero-filled " << numZeroFills << "\n";
+    if (numTLBHits + numTLBMisses > 0) {
+        cout << "TLB: hits " << numTLBHits;
+        cout << ", misses " << numTLBMisses << "\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
     cout << ", sent " << numPacketsSent << "\n";
 }
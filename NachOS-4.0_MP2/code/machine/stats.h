@@ -33,6 +33,15 @@ class Statistics {
     int numConsoleCharsRead;     // number of characters read from the keyboard
     int numConsoleCharsWritten;  // number of characters written to the display
     int numPageFaults;           // number of virtual memory page faults
+    int numSwapReads;            // pages read from the swap area
+    int numSwapWrites;           // pages written to the swap area
+    int numSharedFaults;         // page faults on a page another space
+                                 // had in memory already
+    int numCopyOnWrites;         // shared pages copied when written
+    int numZeroFills;            // pages filled with zeros when first
+                                 // touched
+    int numTLBHits;              // user addresses found in the TLB
+    int numTLBMisses;            // and not found there
     int numPacketsSent;          // number of packets sent over the network
     int numPacketsRecvd;         // number of packets received over the network
 
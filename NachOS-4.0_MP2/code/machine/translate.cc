@@ -79,6 +79,9 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
 //	"value" -- the place to write the result
+//
+//	Aligned words, the common case, are read without the checks and
+//	tracing of the general path when QuickTranslate can do it.
 //----------------------------------------------------------------------
 
 bool Machine::ReadMem(int addr, int size, int *value) {
@@ -86,6 +89,15 @@ bool Machine::ReadMem(int addr, int size, int *value) {
     ExceptionType exception;
     int physicalAddress;
 
+    if (size == 4 && QuickTranslate(addr, &physicalAddress, ReadAccess)) {
+#ifdef HOST_IS_BIG_ENDIAN
+        *value = WordToHost(*(unsigned int *)&mainMemory[physicalAddress]);
+#else
+        *value = *(int *)&mainMemory[physicalAddress];  // already in host order
+#endif
+        return TRUE;
+    }
+
     DEBUG(dbgAddr, "Reading VA " << addr << ", size " << size);
 
     exception = Translate(addr, &physicalAddress, size, FALSE);
@@ -128,12 +140,25 @@ bool Machine::ReadMem(int addr, int size, int *value) {
 //	"addr" -- the virtual address to write to
 //	"size" -- the number of bytes to be written (1, 2, or 4)
 //	"value" -- the data to be written
+//
+//	Aligned words are written the quick way, as in ReadMem.
 //----------------------------------------------------------------------
 
 bool Machine::WriteMem(int addr, int size, int value) {
     ExceptionType exception;
     int physicalAddress;
 
+    if (size == 4 && QuickTranslate(addr, &physicalAddress, WriteAccess)) {
+        InvalidateDecoded(physicalAddress / PageSize);
+#ifdef HOST_IS_BIG_ENDIAN
+        *(unsigned int *)&mainMemory[physicalAddress] = WordToMachine((unsigned int)value);
+#else
+        *(int *)&mainMemory[physicalAddress] = value;  // host order is
+                                                       // machine order
+#endif
+        return TRUE;
+    }
+
     DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
@@ -141,6 +166,7 @@ bool Machine::WriteMem(int addr, int size, int value) {
         RaiseException(exception, addr);
         return FALSE;
     }
+    InvalidateDecoded(physicalAddress / PageSize);
     switch (size) {
         case 1:
             mainMemory[physicalAddress] = (unsigned char)(value & 0xff);
@@ -209,17 +235,20 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing) {
         }
         entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-            if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
+        for (entry = NULL, i = 0; i < tlbSize; i++)
+            if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn)) &&
+                tlb[i].asid == asid) {
                 entry = &tlb[i];  // FOUND!
                 break;
             }
         if (entry == NULL) {  // not found
             DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
+            kernel->stats->numTLBMisses++;
             return PageFaultException;  // really, this is a TLB fault,
                                         // the page may be in memory,
                                         // but not in the TLB
         }
+        tlbLastUse[i] = ++kernel->stats->numTLBHits;
     }
 
     if (entry->readOnly && writing) {  // trying to write to a read-only page
@@ -242,3 +271,60 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing) {
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::QuickTranslate
+// 	Translate the word address "virtAddr" as Translate would, with
+//	the same effect on the use and dirty bits and the TLB statistics,
+//	if that can be done without an exception or a trace message.
+//	Otherwise return FALSE, having changed nothing, so the caller can
+//	go through Translate.
+//
+//	With a TLB, the entry that last translated the same type of
+//	access is tried before searching, since the code, the data and
+//	the stack are each usually on a page of their own.  The entry
+//	is checked, not trusted, so the kernel may change the TLB at any
+//	time.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"physAddr" -- the place to store the physical address
+//	"type" -- whether the word is read, written, or an instruction
+//----------------------------------------------------------------------
+
+bool Machine::QuickTranslate(int virtAddr, int *physAddr, AccessType type) {
+    unsigned int vpn = (unsigned)virtAddr / PageSize;
+    TranslationEntry *entry;
+    int i;
+
+    if (traceAddr || (virtAddr & 0x3))
+        return FALSE;
+    if (tlb == NULL) {
+        if (vpn >= pageTableSize || !pageTable[vpn].valid)
+            return FALSE;
+        entry = &pageTable[vpn];
+    } else {
+        i = lastTlbEntry[type];
+        if (!tlb[i].valid || tlb[i].virtualPage != (int)vpn || tlb[i].asid != asid) {
+            for (i = 0; i < tlbSize; i++) {
+                if (tlb[i].valid && tlb[i].virtualPage == (int)vpn &&
+                    tlb[i].asid == asid)
+                    break;
+            }
+            if (i == tlbSize)
+                return FALSE;  // a TLB miss
+            lastTlbEntry[type] = i;
+        }
+        entry = &tlb[i];
+    }
+    if ((entry->readOnly && type == WriteAccess) ||
+        (unsigned)entry->physicalPage >= NumPhysPages)
+        return FALSE;
+
+    if (tlb != NULL)
+        tlbLastUse[i] = ++kernel->stats->numTLBHits;
+    entry->use = TRUE;
+    if (type == WriteAccess)
+        entry->dirty = TRUE;
+    *physAddr = entry->physicalPage * PageSize + (unsigned)virtAddr % PageSize;
+    return TRUE;
+}
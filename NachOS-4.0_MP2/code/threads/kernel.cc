@@ -9,8 +9,10 @@
 
 #include "copyright.h"
 #include "debug.h"
+#include "frametable.h"
 #include "libtest.h"
 #include "main.h"
+#include "pager.h"
 #include "post.h"
 #include "string.h"
 #include "synch.h"
@@ -18,6 +20,7 @@
 #include "synchdisk.h"
 #include "synchlist.h"
 #include "sysdep.h"
+#include "tlbmgr.h"
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -31,6 +34,11 @@ Kernel::Kernel(int argc, char **argv) {
     execExit = FALSE;
     consoleIn = NULL;   // default is stdin
     consoleOut = NULL;  // default is stdout
+    pagePolicy = NULL;  // default is the clock
+    tlbSize = 0;        // default is the linear page table
+    tlbPolicy = NULL;   // default is LRU
+    frameStats = FALSE;
+    execMode = ExecInterpret;  // default is one instruction at a time
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
@@ -81,6 +89,29 @@ Kernel::Kernel(int argc, char **argv) {
             cout << "Partial usage: nachos [-nf]\n";
 #endif
             cout << "Partial usage: nachos [-n #] [-m #]\n";
+            cout << "Partial usage: nachos [-pr fifo|clock|lru]\n";
+            cout << "Partial usage: nachos [-tlb #] [-tr random|fifo|lru]\n";
+            cout << "Partial usage: nachos [-fs]\n";
+            cout << "Partial usage: nachos [-bb] [-bbcheck]\n";
+        } else if (strcmp(argv[i], "-pr") == 0) {
+            ASSERT(i + 1 < argc);
+            pagePolicy = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-tlb") == 0) {
+            ASSERT(i + 1 < argc);  // next argument is int
+            tlbSize = atoi(argv[i + 1]);
+            ASSERT(tlbSize > 0);
+            i++;
+        } else if (strcmp(argv[i], "-fs") == 0) {
+            frameStats = TRUE;
+        } else if (strcmp(argv[i], "-bb") == 0) {
+            execMode = ExecBlocks;
+        } else if (strcmp(argv[i], "-bbcheck") == 0) {
+            execMode = ExecCheckBlocks;
+        } else if (strcmp(argv[i], "-tr") == 0) {
+            ASSERT(i + 1 < argc);
+            tlbPolicy = argv[i + 1];
+            i++;
         }
     }
 }
@@ -104,7 +135,7 @@ void Kernel::Initialize() {
     interrupt = new Interrupt;       // start up interrupt handling
     scheduler = new Scheduler();     // initialize the ready queue
     alarm = new Alarm(randomSlice);  // start up time slicing
-    machine = new Machine(debugUserProg);
+    machine = new Machine(debugUserProg, tlbSize, execMode);
     synchConsoleIn = new SynchConsoleInput(consoleIn);     // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut);  // output to stdout
     synchDisk = new SynchDisk();                           //
@@ -115,27 +146,16 @@ void Kernel::Initialize() {
 #endif  // FILESYS_STUB
     postOfficeIn = new PostOfficeInput(10);
     postOfficeOut = new PostOfficeOutput(reliability);
-
-    // TODO
-
-    Frame_Table_status = new int[NumPhysPages];                        // int array which size is the amount of physycal pages
-    for (int i = 0; i < NumPhysPages; i++) Frame_Table_status[i] = 0;  // initialize frame table
+    frameTable = new FrameTable();  // every frame free
+    pager = new Pager(pagePolicy);  // page in user programs on demand
+    if (machine->tlb != NULL)
+        tlbManager = new TlbManager(tlbPolicy);
+    else
+        tlbManager = NULL;
 
     interrupt->Enable();
 }
 
-// TODO
-
-int Kernel::Find_Frame() {
-    for (int i = 0; i < NumPhysPages; i++) {
-        if (Frame_Table_status[i] == 0) {  // frame[i] is empty
-            Frame_Table_status[i] = 1;
-            return i;
-        }
-    }
-    return -1;
-}
-
 //----------------------------------------------------------------------
 // Kernel::~Kernel
 // 	Nachos is halting.  De-allocate global data structures.
@@ -153,6 +173,9 @@ Kernel::~Kernel() {
     delete fileSystem;
     delete postOfficeIn;
     delete postOfficeOut;
+    delete pager;
+    delete frameTable;
+    delete tlbManager;
 
     Exit(0);
 }
@@ -24,6 +24,9 @@ class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class FrameTable;
+class Pager;
+class TlbManager;
 
 typedef int OpenFileId;
 
@@ -36,10 +39,6 @@ class Kernel {
     void Initialize();  // initialize the kernel -- separated
                         // from constructor because
                         // refers to "kernel" as a global
-    // TODO
-
-    int Find_Frame();  // To find available frame
-
     void ExecAll();
     int Exec(char *name);
     void ThreadSelfTest();  // self test of threads and synchronization
@@ -71,15 +70,15 @@ class Kernel {
     FileSystem *fileSystem;
     PostOfficeInput *postOfficeIn;
     PostOfficeOutput *postOfficeOut;
+    FrameTable *frameTable;  // physical page frames
+    Pager *pager;  // demand paging
+    TlbManager *tlbManager;  // loads the TLB, NULL if there is none
     bool execExit;       // exit if all threads are finished
     int execRunningNum;  // number of running threads
+    bool frameStats;     // print frame usage when halting
 
     int hostName;  // machine identifier
 
-    // TODO
-
-    int *Frame_Table_status;  // a pointer which point to an array store the frame is empty or not
-
    private:
     Thread *t[10];
     char *execfile[10];
@@ -90,6 +89,11 @@ class Kernel {
     double reliability;  // likelihood messages are dropped
     char *consoleIn;     // file to read console input from
     char *consoleOut;    // file to send console output to
+    char *pagePolicy;    // page replacement policy, from -pr
+    int tlbSize;         // TLB entries, from -tlb; 0 for none
+    char *tlbPolicy;     // TLB replacement policy, from -tr
+    ExecMode execMode;   // run user programs a block at a time,
+                         // from -bb or -bbcheck
 #ifndef FILESYS_STUB
     bool formatFlag;  // format the disk if this is true
 #endif
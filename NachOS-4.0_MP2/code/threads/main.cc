@@ -7,7 +7,8 @@
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -pr <policy> -tlb <size> -tr <policy> -fs
+//              -bb -bbcheck -I <number of alarms>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
@@ -19,8 +20,20 @@
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
 //    -K run a simple self test of kernel threads and synchronization
+//    -I stress the queue of pending interrupts with that many alarms
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -pr chooses the page replacement policy: fifo, clock (the default)
+//       or lru (see pager.h)
+//    -tlb runs user programs with a TLB of that many entries, instead of
+//       the page table (see tlbmgr.h)
+//    -tr chooses the TLB replacement policy: random, fifo or lru (the
+//       default)
+//    -fs prints how the physical page frames were used, when halting
+//    -bb runs user programs a block of instructions at a time, instead
+//       of one at a time (see mipsblock.h)
+//    -bbcheck is -bb, but checks each instruction against the
+//       one-at-a-time interpreter
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -160,6 +173,7 @@ int main(int argc, char **argv) {
     char *debugArg = "";
     char *userProgName = NULL;  // default is not to execute a user prog
     bool threadTestFlag = false;
+    int interruptTestAlarms = 0;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
 #ifndef FILESYS_STUB
@@ -187,6 +201,10 @@ int main(int argc, char **argv) {
             i++;
         } else if (strcmp(argv[i], "-K") == 0) {
             threadTestFlag = TRUE;
+        } else if (strcmp(argv[i], "-I") == 0) {
+            ASSERT(i + 1 < argc);
+            interruptTestAlarms = atoi(argv[i + 1]);
+            i++;
         } else if (strcmp(argv[i], "-C") == 0) {
             consoleTestFlag = TRUE;
         } else if (strcmp(argv[i], "-N") == 0) {
@@ -216,6 +234,7 @@ int main(int argc, char **argv) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
             cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+            cout << "Partial usage: nachos [-I numAlarms]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
@@ -238,6 +257,10 @@ int main(int argc, char **argv) {
     if (threadTestFlag) {
         kernel->ThreadSelfTest();  // test threads and synchronization
     }
+    if (interruptTestAlarms > 0) {
+        kernel->interrupt->SelfTest(interruptTestAlarms);  // stress the
+                                                           // interrupt queue
+    }
     if (consoleTestFlag) {
         kernel->ConsoleTest();  // interactive test of the synchronized console
     }
@@ -20,7 +20,8 @@
 #include "copyright.h"
 #include "machine.h"
 #include "main.h"
-#include "noff.h"
+#include "pager.h"
+#include "tlbmgr.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -82,32 +83,54 @@ AddrSpace::AddrSpace() {
 // TODO
 
 AddrSpace::AddrSpace() {
+    pageTable = NULL;
+    numPages = 0;
+    executable = NULL;
+    swapSector = NULL;
+    inSwap = NULL;
+    asid = -1;
+    image = NULL;
+    shared = NULL;
+    copyOnWrite = NULL;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space: give back its frames and its swap
+//	sectors, and close the executable.
 //----------------------------------------------------------------------
 
 // TODO
 
 AddrSpace::~AddrSpace() {
-    for (int i = 0; i < numPages; i++) {
-        if (pageTable[i].valid == 1) {
-            int phys_Page_num = pageTable[i].physicalPage;
-            kernel->Frame_Table_status[phys_Page_num] = false;
-            pageTable[i].valid = false;
+    if (asid != -1)
+        kernel->tlbManager->EndSpace(asid);
+    if (pageTable != NULL) {
+        kernel->pager->Release(this);
+        for (int i = 0; i < numPages; i++) {
+            if (swapSector[i] != -1)
+                kernel->pager->FreeSwap(swapSector[i]);
         }
+        kernel->pager->UnreserveSwap(numPages);
+        delete[] pageTable;
+        delete[] swapSector;
+        delete[] inSwap;
+        delete[] shared;
+        delete[] copyOnWrite;
     }
-    delete pageTable;
+    delete executable;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::Load
 // 	Load a user program into memory from a file.
 //
-//	Assumes that the page table has been initialized, and that
-//	the object code file is in NOFF format.
+//	Nothing is read yet but the header: every page starts out
+//	invalid, and is brought in by the pager when it is first
+//	touched.  Room in the swap area is reserved for every page, so
+//	the program can be as big as the swap area, not physical memory.
+//
+//	Assumes that the object code file is in NOFF format.
 //
 //	"fileName" is the file containing the object code to load into memory
 //--------
@@ -115,10 +138,9 @@ AddrSpace::~AddrSpace() {
 // TODO
 
 bool AddrSpace::Load(char *fileName) {
-    OpenFile *executable = kernel->fileSystem->Open(fileName);
-    NoffHeader noffH;
     unsigned int size;
 
+    executable = kernel->fileSystem->Open(fileName);
     if (executable == NULL) {
         cerr << "Unable to open file " << fileName << "\n";
         return FALSE;
@@ -147,145 +169,166 @@ bool AddrSpace::Load(char *fileName) {
 
     // TODO
 
-    // thread 需要的page數 , 最大的page table數量
-    if (numPages > NumPhysPages) {
+    // every page may need a sector in the swap area
+    if (!kernel->pager->ReserveSwap(numPages)) {
         kernel->interrupt->setStatus(SystemMode);
         ExceptionHandler(MemoryLimitException);
         kernel->interrupt->setStatus(UserMode);
     }
 
-    ASSERT(numPages <= NumPhysPages);  // check we're not trying
-                                       // to run anything too big --
-                                       // at least until we have
-                                       // virtual memory
-
     DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
 
-    // then, copy in the code and data segments into memory
-
-    // virtual address != physical address
-
-    // virtual address % page size => page offset
-
-    // page offset + frame number * page size = physical address
-
     pageTable = new TranslationEntry[numPages];  // create page table which size is the amount of numPages for this thread
+    swapSector = new int[numPages];
+    inSwap = new bool[numPages];
+    shared = new bool[numPages];
+    copyOnWrite = new bool[numPages];
 
     for (int i = 0; i < numPages; i++) {
-        int frame_number = kernel->Find_Frame();
-
-        if (frame_number == -1) {
-            ExceptionHandler(MemoryLimitException);
-            return false;
-        }
-
         pageTable[i].virtualPage = i;
-        pageTable[i].physicalPage = frame_number;
-        pageTable[i].valid = TRUE;
+        pageTable[i].physicalPage = -1;
+        pageTable[i].valid = FALSE;  // brought in on the first page fault
         pageTable[i].use = FALSE;
         pageTable[i].dirty = FALSE;
         pageTable[i].readOnly = FALSE;
-        bzero(kernel->machine->mainMemory + frame_number * PageSize, PageSize);
+        swapSector[i] = -1;  // chosen when first written out
+        inSwap[i] = FALSE;
+        shared[i] = FALSE;
+        copyOnWrite[i] = FALSE;
     }
 
-    unsigned int physAddr;
-    ExceptionType status;
-
-    if (noffH.code.size > 0) {
-        DEBUG(dbgAddr, "Initializing code segment.");
-        DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
+#ifdef RDATA
 
-        unsigned int page_amount = divRoundUp(noffH.code.size, PageSize);  // the amount of pages in code
+    if (noffH.readonlyData.size > 0) {
+        unsigned int page_amount = divRoundUp(noffH.readonlyData.size, PageSize);  // the amount of pages in readonlyData
+        // count page number to set the read only bit
+        unsigned int page_num;  // the virtual page number
 
-        int cur = 0;
         for (int i = 0; i < page_amount; i++) {
-            status = Translate(noffH.code.virtualAddr + cur, &physAddr, 0);
-
-            if (status != NoException) {
-                kernel->interrupt->setStatus(SystemMode);
-                ExceptionHandler(status);
-                kernel->interrupt->setStatus(UserMode);
-            }
-
-            unsigned int LoadSize;
-            if (i == page_amount - 1)
-                LoadSize = noffH.code.size - (page_amount - 1) * PageSize;  // the last page may have internal fragmentation
-            else
-                LoadSize = PageSize;
-
-            executable->ReadAt(&(kernel->machine->mainMemory[physAddr]), LoadSize, noffH.code.inFileAddr + cur);
-            cur += PageSize;
+            page_num = (noffH.readonlyData.virtualAddr / PageSize) + i;  // calculate virtual page number = 起始page table index + total耗費table數
+            pageTable[page_num].readOnly = TRUE;
         }
     }
 
-    if (noffH.initData.size > 0) {
-        DEBUG(dbgAddr, "Initializing data segment.");
-        DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-
-        unsigned int page_amount = divRoundUp(noffH.initData.size, PageSize);  // the amount of pages in initData
+    // END
+#endif
 
-        int cur = 0;
-        for (int i = 0; i < page_amount; i++) {
-            status = Translate(noffH.initData.virtualAddr + cur, &physAddr, 0);
-
-            if (status != NoException) {
-                kernel->interrupt->setStatus(SystemMode);
-                ExceptionHandler(status);
-                kernel->interrupt->setStatus(UserMode);
-            }
-
-            unsigned int LoadSize;
-            if (i == page_amount - 1)
-                LoadSize = noffH.initData.size - (page_amount - 1) * PageSize;  // the last page may have internal fragmentation
-            else
-                LoadSize = PageSize;
-
-            executable->ReadAt(&(kernel->machine->mainMemory[physAddr]), LoadSize, noffH.initData.inFileAddr + cur);
-            cur += PageSize;
+    // the pages that come from the executable are shared, and read
+    // only; unless they were read only already, they are copied on
+    // the first write
+    image = kernel->pager->Attach(this, fileName);
+    for (int i = 0; i < numPages; i++) {
+        if (FromFile(i)) {
+            shared[i] = TRUE;
+            copyOnWrite[i] = !pageTable[i].readOnly;
+            pageTable[i].readOnly = TRUE;
         }
     }
 
-#ifdef RDATA
+    if (kernel->tlbManager != NULL)
+        asid = kernel->tlbManager->NewSpace(this, fileName);
 
-    if (noffH.readonlyData.size > 0) {
-        DEBUG(dbgAddr, "Initializing read only data segment.");
-        DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
+    return TRUE;  // success
+}
 
-        unsigned int page_amount = divRoundUp(noffH.readonlyData.size, PageSize);  // the amount of pages in readonlyData
-        // count page number to set the read only bit
-        unsigned int page_num;  // the virtual page number
+//----------------------------------------------------------------------
+// AddrSpace::FetchPage
+// 	Fill "frame" with the contents of page "vpn": its copy in the
+//	swap area if it was written there, otherwise whatever parts of
+//	the code and data segments fall in the page, and zeros for the
+//	rest.  A page of only uninitialized data or stack is just zeroed.
+//----------------------------------------------------------------------
 
-        for (int i = 0; i < page_amount; i++) {
-            page_num = (noffH.readonlyData.virtualAddr / PageSize) + i;  // calculate virtual page number = 起始page table index + total耗費table數
-            pageTable[page_num].readOnly = TRUE;
-        }
+void AddrSpace::FetchPage(int vpn, int frame) {
+    char *data = &(kernel->machine->mainMemory[frame * PageSize]);
 
-        int cur = 0;
-        for (int i = 0; i < page_amount; i++) {
-            status = Translate(noffH.readonlyData.virtualAddr + cur, &physAddr, 0);  // the last page may have internal fragmentation
-            // if(status != NoException) RaiseException(status);
-            if (status != NoException) {
-                kernel->interrupt->setStatus(SystemMode);
-                ExceptionHandler(status);
-                kernel->interrupt->setStatus(UserMode);
-            }
-
-            unsigned int LoadSize;
-            if (i == page_amount - 1)
-                LoadSize = noffH.readonlyData.size - (page_amount - 1) * PageSize;
-            else
-                LoadSize = PageSize;
-
-            executable->ReadAt(&(kernel->machine->mainMemory[physAddr]), LoadSize, noffH.readonlyData.inFileAddr + cur);
-            cur += PageSize;
-        }
+    if (inSwap[vpn]) {
+        DEBUG(dbgAddr, "Page " << vpn << " from swap sector " << swapSector[vpn]);
+        kernel->pager->ReadSwap(swapSector[vpn], frame);
+        return;
     }
 
-    // END
+    bzero(data, PageSize);
+    if (!FromFile(vpn)) {
+        DEBUG(dbgAddr, "Page " << vpn << " zero-filled");
+        kernel->stats->numZeroFills++;
+        return;
+    }
+    DEBUG(dbgAddr, "Page " << vpn << " from the executable");
+    LoadSegment(&noffH.code, vpn, data);
+    LoadSegment(&noffH.initData, vpn, data);
+#ifdef RDATA
+    LoadSegment(&noffH.readonlyData, vpn, data);
 #endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+// 	Read the part of segment "seg" that falls in page "vpn" from the
+//	executable into "data", the page in main memory.
+//----------------------------------------------------------------------
 
-    delete executable;  // close file
-    return TRUE;        // success
+void AddrSpace::LoadSegment(Segment *seg, int vpn, char *data) {
+    int start = vpn * PageSize;
+    int from = max(start, seg->virtualAddr);
+    int to = min(start + PageSize, seg->virtualAddr + seg->size);
+
+    if (from < to)
+        executable->ReadAt(data + (from - start), to - from,
+                           seg->inFileAddr + (from - seg->virtualAddr));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InSegment
+// 	Return TRUE if part of segment "seg" falls in page "vpn".
+//----------------------------------------------------------------------
+
+bool AddrSpace::InSegment(Segment *seg, int vpn) {
+    int start = vpn * PageSize;
+
+    return seg->size > 0 && seg->virtualAddr < start + PageSize &&
+           start < seg->virtualAddr + seg->size;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FromFile
+// 	Return TRUE if any of page "vpn" comes from the executable, FALSE
+//	if it is all uninitialized data or stack.
+//----------------------------------------------------------------------
+
+bool AddrSpace::FromFile(int vpn) {
+    return InSegment(&noffH.code, vpn) || InSegment(&noffH.initData, vpn)
+#ifdef RDATA
+           || InSegment(&noffH.readonlyData, vpn)
+#endif
+        ;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MakePrivate
+// 	Page "vpn" was shared, and now has a frame of its own with a copy
+//	(see Pager::CopyOnWrite), which may be written.
+//----------------------------------------------------------------------
+
+void AddrSpace::MakePrivate(int vpn) {
+    shared[vpn] = FALSE;
+    copyOnWrite[vpn] = FALSE;
+    pageTable[vpn].readOnly = FALSE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SavePage
+// 	Write page "vpn", in "frame", to its swap sector.  The page is
+//	marked as in swap before the write starts: the thread may sleep
+//	until the disk is done, and this address space may be gone by then.
+//----------------------------------------------------------------------
+
+void AddrSpace::SavePage(int vpn, int frame) {
+    if (swapSector[vpn] == -1)
+        swapSector[vpn] = kernel->pager->AllocSwap();
+    DEBUG(dbgAddr, "Page " << vpn << " to swap sector " << swapSector[vpn]);
+    inSwap[vpn] = TRUE;
+    kernel->pager->WriteSwap(swapSector[vpn], frame);
 }
 
 //----------------------------------------------------------------------
@@ -359,10 +402,15 @@ void AddrSpace::SaveState() {}
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, or
+//	with a TLB, which of its entries are ours (see tlbmgr.h).
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() {
+    if (kernel->tlbManager != NULL) {
+        kernel->tlbManager->SwitchTo(asid);
+        return;
+    }
     kernel->machine->pageTable = pageTable;
     kernel->machine->pageTableSize = numPages;
 }
@@ -388,6 +436,10 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite) {
 
     pte = &pageTable[vpn];
 
+    if (!pte->valid) {
+        return PageFaultException;
+    }
+
     if (isReadWrite && pte->readOnly) {
         return ReadOnlyException;
     }
@@ -415,3 +467,88 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite) {
 
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// AddrSpace::UserAddr
+// 	Return where virtual address "vaddr" is in main memory, bringing
+//	its page in first if needed, or copying it if it is shared and
+//	being written; NULL if it is not a legal address.  If it is being
+//	written, the machine forgets what it decoded from the page.
+//
+//	The pointer is only good until the thread next sleeps, since the
+//	page may be taken away then.
+//----------------------------------------------------------------------
+
+char *AddrSpace::UserAddr(unsigned int vaddr, bool writing) {
+    unsigned int paddr;
+    ExceptionType status;
+
+    for (;;) {
+        status = Translate(vaddr, &paddr, writing);
+        if (status == PageFaultException)
+            kernel->pager->PageIn(this, vaddr / PageSize);
+        else if (status == ReadOnlyException && copyOnWrite[vaddr / PageSize])
+            kernel->pager->CopyOnWrite(this, vaddr / PageSize);
+        else
+            break;
+    }
+    if (status != NoException)
+        return NULL;
+    if (writing)
+        kernel->machine->InvalidateDecoded(paddr / PageSize);
+    return &(kernel->machine->mainMemory[paddr]);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn
+// 	Copy "size" bytes at virtual address "vaddr" into "buf".
+//	Return FALSE if some address is not legal.
+//----------------------------------------------------------------------
+
+bool AddrSpace::CopyIn(unsigned int vaddr, char *buf, int size) {
+    char *p;
+
+    for (int i = 0; i < size; i++) {
+        if ((p = UserAddr(vaddr + i, FALSE)) == NULL)
+            return FALSE;
+        buf[i] = *p;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOut
+// 	Copy "size" bytes from "buf" to virtual address "vaddr".
+//	Return FALSE if some address is not legal, or read only.
+//----------------------------------------------------------------------
+
+bool AddrSpace::CopyOut(unsigned int vaddr, char *buf, int size) {
+    char *p;
+
+    for (int i = 0; i < size; i++) {
+        if ((p = UserAddr(vaddr + i, TRUE)) == NULL)
+            return FALSE;
+        *p = buf[i];
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyInString
+// 	Copy the string at virtual address "vaddr" into "buf", which
+//	holds "size" bytes; a longer string is cut short.  Return FALSE
+//	if some address is not legal.
+//----------------------------------------------------------------------
+
+bool AddrSpace::CopyInString(unsigned int vaddr, char *buf, int size) {
+    char *p;
+
+    for (int i = 0; i < size - 1; i++) {
+        if ((p = UserAddr(vaddr + i, FALSE)) == NULL)
+            return FALSE;
+        if ((buf[i] = *p) == '\0')
+            return TRUE;
+    }
+    buf[size - 1] = '\0';
+    return TRUE;
+}
@@ -16,9 +16,14 @@
 #include "copyright.h"
 #include "filesys.h"
 #include "machine.h"
+#include "noff.h"
 
 #define UserStackSize 1024  // increase this as necessary!
 
+#define UserStringMax 256  // longest string passed to a system call
+
+class SharedImage;
+
 class AddrSpace {
    public:
     AddrSpace();   // Create an address space.
@@ -40,12 +45,51 @@ class AddrSpace {
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    // Copy between user memory and the kernel, bringing pages in as
+    // needed.  Return FALSE if an address is not legal.
+    bool CopyIn(unsigned int vaddr, char *buf, int size);
+    bool CopyOut(unsigned int vaddr, char *buf, int size);
+    bool CopyInString(unsigned int vaddr, char *buf, int size);
+    // Up to and including the '\0';
+    // at most "size" bytes with it
+
+    // Demand paging, see pager.h
+    TranslationEntry *GetEntry(int vpn) { return &pageTable[vpn]; }
+    int NumPages() { return numPages; }
+    int GetASID() { return asid; }  // see tlbmgr.h
+
+    // Sharing pages with other spaces running the same executable
+    SharedImage *GetImage() { return image; }
+    bool IsShared(int vpn) { return shared[vpn]; }
+    bool IsCopyOnWrite(int vpn) { return copyOnWrite[vpn]; }
+    void MakePrivate(int vpn);  // The page was copied on write
+    void FetchPage(int vpn, int frame);  // Fill "frame" with page "vpn"
+    void SavePage(int vpn, int frame);   // Write it to the swap area
+
    private:
     TranslationEntry *pageTable;  // Assume linear page table translation
                                   // for now!
     unsigned int numPages;        // Number of pages in the virtual
                                   // address space
 
+    OpenFile *executable;  // where pages not in swap come from
+    NoffHeader noffH;      // and where in the file they are
+    int *swapSector;       // swap sector reserved for each page
+    bool *inSwap;          // is the page's latest copy there?
+    int asid;              // tags its TLB entries; -1 if no TLB
+    SharedImage *image;    // its pages shared with other spaces
+    bool *shared;          // does the page map a shared frame?
+    bool *copyOnWrite;     // and if so, may it be written?
+
+    bool InSegment(Segment *seg, int vpn);
+    // Does part of "seg" fall in page "vpn"?
+    bool FromFile(int vpn);  // Or of any segment in the file?
+    void LoadSegment(Segment *seg, int vpn, char *data);
+    // Copy the part of "seg" in page "vpn"
+    // from the executable
+    char *UserAddr(unsigned int vaddr, bool writing);
+    // Where "vaddr" is in main memory
+
     void InitRegisters();  // Initialize user-level CPU registers,
                            // before jumping to user code
 };
@@ -24,7 +24,9 @@
 #include "copyright.h"
 #include "ksyscall.h"
 #include "main.h"
+#include "pager.h"
 #include "syscall.h"
+#include "tlbmgr.h"
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -97,8 +99,9 @@ void ExceptionHandler(ExceptionType which) {
                     val = kernel->machine->ReadRegister(4);
                     // print the message in the addr
                     {
-                        // read the addr's data in memory/cache
-                        char *msg = &(kernel->machine->mainMemory[val]);
+                        // copy the message out of user memory
+                        char msg[UserStringMax];
+                        kernel->currentThread->space->CopyInString(val, msg, UserStringMax);
                         // print the msg
                         cout << msg << endl;
                     }
@@ -114,10 +117,12 @@ void ExceptionHandler(ExceptionType which) {
                     // create the file (filename store in the reg)
                     {
                         // read the addr's data from memory(store the filename)
-                        char *filename = &(kernel->machine->mainMemory[val]);
-                        // cout << filename << endl;
-                        // call syscreate to create a file with filename->filename
-                        status = SysCreate(filename);
+                        char filename[UserStringMax];
+                        if (!kernel->currentThread->space->CopyInString(val, filename, UserStringMax))
+                            status = 0;
+                        else
+                            // call syscreate to create a file with filename->filename
+                            status = SysCreate(filename);
                         // store the result back to reg 2
                         kernel->machine->WriteRegister(2, (int)status);
                     }
@@ -139,10 +144,12 @@ void ExceptionHandler(ExceptionType which) {
                     // open the file (filename store in the reg)
                     {
                         // read the addr's data from memory(store the filename)
-                        char *filename = &(kernel->machine->mainMemory[val]);
-                        // cout << filename << endl;
-                        // call SysOpen to open a file with filename->filename
-                        status = SysOpen(filename);
+                        char filename[UserStringMax];
+                        if (!kernel->currentThread->space->CopyInString(val, filename, UserStringMax))
+                            status = -1;
+                        else
+                            // call SysOpen to open a file with filename->filename
+                            status = SysOpen(filename);
                         // store the result back to reg 2
                         kernel->machine->WriteRegister(2, (int)status);
                     }
@@ -164,13 +171,13 @@ void ExceptionHandler(ExceptionType which) {
                     fileID = kernel->machine->ReadRegister(6);
                     // open the file (filename store in the reg)
                     {
-                        // read the addr's data from memory(store the filename)
-                        char *buf = &(kernel->machine->mainMemory[val]);
+                        // read into the kernel, then copy to the user's buffer
+                        char *buf = new char[max(numChar, 1)];
 
-                        // cout << filename << endl;
-                        // call SysOpen to open a file with filename->filename
-                        status = SysRead(buf, numChar, fileID);
-                        // status = SysOpen(filename);
+                        status = (numChar < 0) ? -1 : SysRead(buf, numChar, fileID);
+                        if (status > 0 && !kernel->currentThread->space->CopyOut(val, buf, status))
+                            status = -1;
+                        delete[] buf;
                         // store the result back to reg 2
                         kernel->machine->WriteRegister(2, (int)status);
                     }
@@ -192,11 +199,14 @@ void ExceptionHandler(ExceptionType which) {
                     fileID = kernel->machine->ReadRegister(6);
                     // open the file (filename store in the reg)
                     {
-                        // read the addr's data from memory(store the filename)
-                        char *buf = &(kernel->machine->mainMemory[val]);
-                        // cout << filename << endl;
-                        // call SysOpen to open a file with filename->filename
-                        status = SysWrite(buf, numChar, fileID);
+                        // copy the user's buffer into the kernel first
+                        char *buf = new char[max(numChar, 1)];
+
+                        if (numChar < 0 || !kernel->currentThread->space->CopyIn(val, buf, numChar))
+                            status = -1;
+                        else
+                            status = SysWrite(buf, numChar, fileID);
+                        delete[] buf;
                         // store the result back to reg 2
                         kernel->machine->WriteRegister(2, (int)status);
                     }
@@ -289,6 +299,32 @@ void ExceptionHandler(ExceptionType which) {
             }
             break;
 
+        // a page that is not in memory yet: bring it in, and run
+        // the instruction again (the PC was not moved on).  With a
+        // TLB, a page that is not in the TLB: load it, bringing it
+        // into memory first if need be
+        case PageFaultException:
+            val = kernel->machine->ReadRegister(BadVAddrReg);
+            if (kernel->tlbManager == NULL) {
+                kernel->pager->PageIn(kernel->currentThread->space, (unsigned)val / PageSize);
+                return;
+            }
+            if (kernel->tlbManager->Refill(kernel->currentThread->space, (unsigned)val / PageSize))
+                return;
+            cerr << "Illegal virtual address " << (unsigned)val << "\n";
+            break;
+
+        // a write to a page shared with other programs running the
+        // same executable: give this one a copy, and write again
+        case ReadOnlyException:
+            val = kernel->machine->ReadRegister(BadVAddrReg);
+            if (kernel->currentThread->space->IsCopyOnWrite((unsigned)val / PageSize)) {
+                kernel->pager->CopyOnWrite(kernel->currentThread->space, (unsigned)val / PageSize);
+                return;
+            }
+            cerr << "Write to read-only address " << (unsigned)val << "\n";
+            break;
+
         // user mode error
         default:
             cerr << "Unexpected user mode exception " << (int)which << "\n";
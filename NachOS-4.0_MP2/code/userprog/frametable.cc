@@ -0,0 +1,132 @@
+// frametable.cc
+//	Routines to manage the table of physical page frames.  See
+//	frametable.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "frametable.h"
+
+#include "addrspace.h"
+#include "copyright.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the table, with every frame on the free list, lowest
+//	first.
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable() {
+    for (int i = 0; i < NumPhysPages; i++) {
+        frames[i].owner = NULL;
+        frames[i].vpn = -1;
+        frames[i].entry = NULL;
+        frames[i].shared = NULL;
+        frames[i].refCount = 0;
+        frames[i].pinCount = 0;
+        frames[i].loadTime = 0;
+        frames[i].nextFree = (i + 1 < NumPhysPages) ? i + 1 : -1;
+    }
+    freeList = 0;
+    numFree = NumPhysPages;
+    maxInUse = numAllocs = numLoads = 0;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Alloc
+// 	Take the first frame off the free list, and return it; return -1
+//	if every frame is in use.
+//----------------------------------------------------------------------
+
+int FrameTable::Alloc() {
+    int frame = freeList;
+
+    if (frame == -1)
+        return -1;
+    freeList = frames[frame].nextFree;
+    frames[frame].nextFree = -1;
+    numFree--;
+    numAllocs++;
+    if (NumPhysPages - numFree > maxInUse)
+        maxInUse = NumPhysPages - numFree;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	Put "frame" back on the free list.  It must not be pinned.
+//----------------------------------------------------------------------
+
+void FrameTable::Free(int frame) {
+    FrameInfo *f = &frames[frame];
+
+    ASSERT(f->pinCount == 0);
+    f->owner = NULL;
+    f->vpn = -1;
+    f->entry = NULL;
+    f->shared = NULL;
+    f->refCount = 0;
+    f->nextFree = freeList;
+    freeList = frame;
+    numFree++;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Assign
+// 	Record that page "vpn" of "space" is being put in "frame", which
+//	was just taken off the free list or away from another page.  The
+//	page is not shared until the pager says so.  Whatever the machine
+//	decoded from the frame's old contents is no good any more.
+//----------------------------------------------------------------------
+
+void FrameTable::Assign(int frame, AddrSpace *space, int vpn) {
+    FrameInfo *f = &frames[frame];
+
+    kernel->machine->InvalidateDecoded(frame);
+    f->owner = space;
+    f->vpn = vpn;
+    f->entry = space->GetEntry(vpn);
+    f->shared = NULL;
+    f->refCount = 1;
+    f->loadTime = ++numLoads;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Unpin
+// 	Undo one Pin of "frame".
+//----------------------------------------------------------------------
+
+void FrameTable::Unpin(int frame) {
+    ASSERT(frames[frame].pinCount > 0);
+    frames[frame].pinCount--;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Print
+// 	Print how many frames are in use, pinned and shared now, the
+//	most that were in use at once, and how many pages were put in
+//	frames, and how many of those were just zeroed.
+//----------------------------------------------------------------------
+
+void FrameTable::Print() {
+    int numPinned = 0, numShared = 0, numMaps = 0;
+
+    for (int i = 0; i < NumPhysPages; i++) {
+        if (frames[i].pinCount > 0)
+            numPinned++;
+        if (frames[i].shared != NULL) {
+            numShared++;
+            numMaps += frames[i].refCount;
+        }
+    }
+    cout << "Frames: " << NumPhysPages << " total, "
+         << NumPhysPages - numFree << " in use, " << numPinned
+         << " pinned, at most " << maxInUse << " in use\n";
+    cout << "Frames: " << numShared << " shared, mapped by "
+         << numMaps << " page table entries\n";
+    cout << "Frames: taken off the free list " << numAllocs
+         << ", pages loaded " << numLoads << ", of them zero-filled "
+         << kernel->stats->numZeroFills << "\n";
+}
@@ -0,0 +1,74 @@
+// frametable.h
+//	Data structures to keep track of the physical page frames of the
+//	machine: which are free, and for those in use, which page of
+//	which address space is in them.
+//
+//	The free frames are kept on a list threaded through the table,
+//	so allocating and freeing a frame take constant time.  A frame in
+//	use can be pinned, for instance while it is being filled from the
+//	disk, so that the pager does not take it away.  A frame holding a
+//	page shared by several address spaces counts how many map it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class AddrSpace;
+class SharedImage;
+
+// The following class defines what is known about one frame.
+
+class FrameInfo {
+   public:
+    AddrSpace *owner;         // space whose page is in the frame,
+                              // NULL if the frame is free
+    int vpn;                  // which of its pages
+    TranslationEntry *entry;  // and that page's table entry
+    SharedImage *shared;      // if not NULL, the page is shared by
+                              // the spaces running this executable,
+                              // and "owner" is one of them
+    int refCount;             // page tables mapping the frame
+    int pinCount;             // the frame may not be taken away
+                              // unless this is 0
+    int loadTime;             // when the page was put in the frame,
+                              // in pages put in frames so far
+    int nextFree;             // next frame on the free list, or -1
+};
+
+// The following class defines the table of frames.
+
+class FrameTable {
+   public:
+    FrameTable();  // Every frame is free
+
+    int Alloc();  // Take a frame off the free list;
+                  // -1 if there is none
+    void Free(int frame);  // Put it back
+    void Assign(int frame, AddrSpace *space, int vpn);
+    // Page "vpn" of "space" is going into
+    // "frame", which is in use
+
+    void Pin(int frame) { frames[frame].pinCount++; }
+    void Unpin(int frame);
+
+    FrameInfo *Info(int frame) { return &frames[frame]; }
+    int NumFree() { return numFree; }
+
+    void Print();  // Print how the frames were used
+
+   private:
+    FrameInfo frames[NumPhysPages];
+    int freeList;   // first free frame, or -1
+    int numFree;    // frames on the free list
+    int maxInUse;   // most frames in use at one time
+    int numAllocs;  // frames taken off the free list
+    int numLoads;   // pages put in frames
+};
+
+#endif  // FRAMETABLE_H
@@ -0,0 +1,503 @@
+// pager.cc
+//	Routines for demand paging: bringing pages in on a page fault,
+//	choosing frames to take away, and the swap area.  See pager.h.
+//
+//	Page faults are handled one at a time, under a lock, since
+//	reading or writing the swap area puts the thread to sleep.  A
+//	page is marked invalid before it is written out, so its owner
+//	faults on it (and waits for the lock) if it runs meanwhile.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "pager.h"
+
+#include "addrspace.h"
+#include "copyright.h"
+#include "main.h"
+#include "synch.h"
+#include "synchdisk.h"
+#include "tlbmgr.h"
+
+//----------------------------------------------------------------------
+// ReplacePolicy::Candidate
+// 	Return the page table entry of the page in "frame", or NULL if
+//	the frame may not be taken away.
+//----------------------------------------------------------------------
+
+TranslationEntry *ReplacePolicy::Candidate(int frame) {
+    FrameInfo *f = frames->Info(frame);
+
+    if (f->owner == NULL || f->pinCount > 0)
+        return NULL;
+    return f->entry;
+}
+
+//----------------------------------------------------------------------
+// FifoReplace::Victim
+// 	Return the frame that was loaded longest ago.
+//----------------------------------------------------------------------
+
+int FifoReplace::Victim() {
+    int victim = -1;
+
+    for (int i = 0; i < NumPhysPages; i++) {
+        if (Candidate(i) != NULL &&
+            (victim == -1 || frames->Info(i)->loadTime < frames->Info(victim)->loadTime))
+            victim = i;
+    }
+    ASSERT(victim != -1);
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// ClockReplace::ClockReplace
+// 	Initialize clock replacement, with the hand at frame 0.
+//----------------------------------------------------------------------
+
+ClockReplace::ClockReplace(FrameTable *table) : ReplacePolicy(table) {
+    hand = 0;
+}
+
+//----------------------------------------------------------------------
+// ClockReplace::Victim
+// 	Move the hand round the frames, giving each frame that was used
+//	since the hand last passed a second chance, and return the first
+//	one that was not.  Takes at most two times round.
+//----------------------------------------------------------------------
+
+int ClockReplace::Victim() {
+    for (int i = 0; i < 2 * NumPhysPages; i++) {
+        int frame = hand;
+        TranslationEntry *e = Candidate(frame);
+
+        hand = (hand + 1) % NumPhysPages;
+        if (e == NULL)
+            continue;
+        if (!e->use)
+            return frame;
+        e->use = FALSE;
+    }
+    ASSERTNOTREACHED();
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// LruReplace::Victim
+// 	The clock, looking at the use and dirty bits together.  First go
+//	round once for a frame neither used lately nor dirty, without
+//	changing anything.  Failing that, go round as the clock does,
+//	but take a frame not used lately even if it is dirty.  So of the
+//	frames not used since the hand last passed, the clean ones go
+//	first.
+//----------------------------------------------------------------------
+
+int LruReplace::Victim() {
+    int frame;
+    TranslationEntry *e;
+
+    for (int i = 0; i < NumPhysPages; i++) {
+        frame = (hand + i) % NumPhysPages;
+        e = Candidate(frame);
+        if (e != NULL && !e->use && !e->dirty) {
+            hand = (frame + 1) % NumPhysPages;
+            return frame;
+        }
+    }
+    return ClockReplace::Victim();
+}
+
+//----------------------------------------------------------------------
+// SharedImage::SharedImage
+// 	Initialize an executable being run, with none of its pages in
+//	memory.
+//
+//	"fileName" -- the executable
+//	"pages" -- how many pages a space running it has
+//----------------------------------------------------------------------
+
+SharedImage::SharedImage(char *fileName, int pages) {
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    numPages = pages;
+    frame = new int[numPages];
+    for (int i = 0; i < numPages; i++)
+        frame[i] = -1;
+    spaces = new List<AddrSpace *>;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::~SharedImage
+// 	De-allocate an executable no space is running any more.
+//----------------------------------------------------------------------
+
+SharedImage::~SharedImage() {
+    delete[] name;
+    delete[] frame;
+    delete spaces;
+}
+
+//----------------------------------------------------------------------
+// Pager::Pager
+// 	Initialize the pager, with the whole swap area free.  The frames
+//	are kept in kernel->frameTable.
+//
+//	"policyName" -- how to choose frames to take away, as given with
+//		-pr, or NULL for the clock
+//----------------------------------------------------------------------
+
+Pager::Pager(char *policyName) {
+    FrameTable *frames = kernel->frameTable;
+
+    ASSERT(PageSize == SectorSize);  // a page fits a sector
+    if (policyName == NULL || strcmp(policyName, "clock") == 0) {
+        policy = new ClockReplace(frames);
+    } else if (strcmp(policyName, "fifo") == 0) {
+        policy = new FifoReplace(frames);
+    } else if (strcmp(policyName, "lru") == 0) {
+        policy = new LruReplace(frames);
+    } else {
+        cerr << "Unknown page replacement policy " << policyName << "\n";
+        ASSERTNOTREACHED();
+    }
+    lock = new Lock("pager");
+    swapMap = new Bitmap(SwapSectors);
+    numReserved = 0;
+    images = new List<SharedImage *>;
+}
+
+//----------------------------------------------------------------------
+// Pager::~Pager
+// 	De-allocate the pager.
+//----------------------------------------------------------------------
+
+Pager::~Pager() {
+    delete policy;
+    delete lock;
+    delete swapMap;
+    while (!images->IsEmpty())
+        delete images->RemoveFront();
+    delete images;
+}
+
+//----------------------------------------------------------------------
+// Pager::PageIn
+// 	Bring page "vpn" of "space" into a frame, taking a frame away
+//	from another page if none is free, and make it valid.
+//
+//	Called when a user program, or the kernel on its behalf, touches
+//	a page that is not valid, or with a TLB, when the TLB is loaded
+//	with a page that is not valid.
+//----------------------------------------------------------------------
+
+void Pager::PageIn(AddrSpace *space, int vpn) {
+    lock->Acquire();
+    if (!space->GetEntry(vpn)->valid)
+        Load(space, vpn);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Pager::Load
+// 	Bring page "vpn" of "space", which is not valid, into a frame.
+//	If it is a shared page that another space has in memory, just
+//	map that frame.  The lock is held.
+//----------------------------------------------------------------------
+
+void Pager::Load(AddrSpace *space, int vpn) {
+    TranslationEntry *pte = space->GetEntry(vpn);
+    SharedImage *image = space->GetImage();
+    int frame;
+
+    kernel->stats->numPageFaults++;
+    if (space->IsShared(vpn) && image->frame[vpn] != -1) {
+        frame = image->frame[vpn];
+        DEBUG(dbgAddr, "Page fault on page " << vpn << ", sharing frame " << frame);
+        kernel->stats->numSharedFaults++;
+        kernel->frameTable->Info(frame)->refCount++;
+    } else {
+        frame = GetFrame(space, vpn);
+        DEBUG(dbgAddr, "Page fault on page " << vpn << ", into frame " << frame);
+
+        space->FetchPage(vpn, frame);
+        if (space->IsShared(vpn)) {
+            kernel->frameTable->Info(frame)->shared = image;
+            image->frame[vpn] = frame;
+        }
+        kernel->frameTable->Unpin(frame);
+    }
+    pte->physicalPage = frame;
+    pte->use = FALSE;
+    pte->dirty = FALSE;
+    pte->valid = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pager::GetFrame
+// 	Return a frame for page "vpn" of "space", pinned so that it is
+//	not taken away while it is being filled.  If no frame is free,
+//	have the policy choose one, make its page invalid, and write the
+//	page to swap if it was changed since it was brought in.  A
+//	shared page is taken away from every space mapping it; it is
+//	never changed, so it need not be written.
+//----------------------------------------------------------------------
+
+int Pager::GetFrame(AddrSpace *space, int vpn) {
+    FrameTable *frames = kernel->frameTable;
+    int frame = frames->Alloc();
+    TranslationEntry *pte = NULL;
+    AddrSpace *oldSpace = NULL;
+
+    if (frame == -1) {
+        if (kernel->tlbManager != NULL)
+            kernel->tlbManager->Sync();  // the use bits are in the TLB
+        frame = policy->Victim();
+        DEBUG(dbgAddr, "Taking frame " << frame << " from page " << frames->Info(frame)->vpn);
+
+        if (frames->Info(frame)->shared != NULL) {
+            Unshare(frame);
+        } else {
+            pte = frames->Info(frame)->entry;
+            oldSpace = frames->Info(frame)->owner;
+            pte->valid = FALSE;  // so Release leaves the frame alone if
+                                 // "oldSpace" goes away during the write
+            if (kernel->tlbManager != NULL)
+                kernel->tlbManager->Invalidate(oldSpace, pte->virtualPage);
+        }
+    }
+    frames->Assign(frame, space, vpn);
+    frames->Pin(frame);
+    if (pte != NULL && pte->dirty)
+        oldSpace->SavePage(pte->virtualPage, frame);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// Pager::Unshare
+// 	Make the shared page in "frame" invalid in every space mapping
+//	it, since the frame is being taken away.
+//----------------------------------------------------------------------
+
+void Pager::Unshare(int frame) {
+    FrameInfo *f = kernel->frameTable->Info(frame);
+    SharedImage *image = f->shared;
+    ListIterator<AddrSpace *> iter(image->spaces);
+
+    for (; !iter.IsDone(); iter.Next()) {
+        AddrSpace *space = iter.Item();
+        TranslationEntry *pte = space->GetEntry(f->vpn);
+
+        if (space->IsShared(f->vpn) && pte->valid) {
+            pte->valid = FALSE;
+            if (kernel->tlbManager != NULL)
+                kernel->tlbManager->Invalidate(space, f->vpn);
+        }
+    }
+    image->frame[f->vpn] = -1;
+}
+
+//----------------------------------------------------------------------
+// Pager::Leave
+// 	"space" no longer maps the shared page in "frame".  Free the
+//	frame if no other space does; otherwise, if "space" was the one
+//	the frame table names, name another.
+//----------------------------------------------------------------------
+
+void Pager::Leave(int frame, AddrSpace *space) {
+    FrameInfo *f = kernel->frameTable->Info(frame);
+    SharedImage *image = f->shared;
+
+    if (--f->refCount == 0) {
+        image->frame[f->vpn] = -1;
+        kernel->frameTable->Free(frame);
+        return;
+    }
+    if (f->owner != space)
+        return;
+
+    ListIterator<AddrSpace *> iter(image->spaces);
+    for (; !iter.IsDone(); iter.Next()) {
+        AddrSpace *other = iter.Item();
+
+        if (other != space && other->IsShared(f->vpn) &&
+            other->GetEntry(f->vpn)->valid) {
+            f->owner = other;
+            f->entry = other->GetEntry(f->vpn);
+            return;
+        }
+    }
+    ASSERTNOTREACHED();  // refCount was wrong
+}
+
+//----------------------------------------------------------------------
+// Pager::CopyOnWrite
+// 	"space" is writing to shared page "vpn": give it a frame of its
+//	own with a copy of the page, and let it write there.  If no other
+//	space maps the page, the frame it is in is simply taken over.
+//----------------------------------------------------------------------
+
+void Pager::CopyOnWrite(AddrSpace *space, int vpn) {
+    FrameTable *frames = kernel->frameTable;
+    TranslationEntry *pte = space->GetEntry(vpn);
+    int oldFrame, frame;
+
+    lock->Acquire();
+    if (space->IsCopyOnWrite(vpn)) {  // not copied while we waited
+        if (!pte->valid)
+            Load(space, vpn);
+        kernel->stats->numCopyOnWrites++;
+        if (kernel->tlbManager != NULL)
+            kernel->tlbManager->Invalidate(space, vpn);  // read only there
+
+        oldFrame = pte->physicalPage;
+        if (frames->Info(oldFrame)->refCount == 1) {
+            DEBUG(dbgAddr, "Copy on write of page " << vpn << ", keeping frame " << oldFrame);
+            ASSERT(frames->Info(oldFrame)->owner == space);
+            space->GetImage()->frame[vpn] = -1;
+            frames->Info(oldFrame)->shared = NULL;
+        } else {
+            frames->Pin(oldFrame);  // GetFrame must not take it away
+            frame = GetFrame(space, vpn);
+            DEBUG(dbgAddr, "Copy on write of page " << vpn << ", into frame " << frame);
+            bcopy(&(kernel->machine->mainMemory[oldFrame * PageSize]),
+                  &(kernel->machine->mainMemory[frame * PageSize]), PageSize);
+            frames->Unpin(oldFrame);
+            Leave(oldFrame, space);
+
+            pte->physicalPage = frame;
+            frames->Unpin(frame);
+        }
+        space->MakePrivate(vpn);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Pager::Attach
+// 	Record that "space" is running "fileName", and return the shared
+//	pages of that executable, starting a new set if no other space is
+//	running it.
+//----------------------------------------------------------------------
+
+SharedImage *Pager::Attach(AddrSpace *space, char *fileName) {
+    ListIterator<SharedImage *> iter(images);
+    SharedImage *image = NULL;
+
+    for (; !iter.IsDone(); iter.Next()) {
+        if (strcmp(iter.Item()->name, fileName) == 0) {
+            image = iter.Item();
+            break;
+        }
+    }
+    if (image == NULL) {
+        image = new SharedImage(fileName, space->NumPages());
+        images->Append(image);
+    }
+    ASSERT(image->numPages == space->NumPages());
+    image->spaces->Append(space);
+    return image;
+}
+
+//----------------------------------------------------------------------
+// Pager::Release
+// 	Free the frames of the pages of "space" that are in memory, since
+//	it is going away; a shared frame is only freed if no other space
+//	maps it.  Does not wait for the lock, since it is called when a
+//	thread is deleted; interrupts are turned off instead.
+//----------------------------------------------------------------------
+
+void Pager::Release(AddrSpace *space) {
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    SharedImage *image = space->GetImage();
+
+    for (int vpn = 0; vpn < space->NumPages(); vpn++) {
+        TranslationEntry *pte = space->GetEntry(vpn);
+
+        if (!pte->valid)
+            continue;
+        if (space->IsShared(vpn)) {
+            Leave(pte->physicalPage, space);
+        } else {
+            ASSERT(kernel->frameTable->Info(pte->physicalPage)->owner == space);
+            kernel->frameTable->Free(pte->physicalPage);
+        }
+        pte->valid = FALSE;
+    }
+    if (image != NULL) {
+        image->spaces->Remove(space);
+        if (image->spaces->IsEmpty()) {
+            images->Remove(image);
+            delete image;
+        }
+    }
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Pager::ReserveSwap
+// 	Promise an address space room in the swap area for "pages"
+//	pages, without choosing the sectors yet.  Return FALSE, and
+//	promise nothing, if there is not that much room left.
+//----------------------------------------------------------------------
+
+bool Pager::ReserveSwap(int pages) {
+    if (numReserved + pages > SwapSectors)
+        return FALSE;
+    numReserved += pages;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pager::UnreserveSwap
+// 	Take back a promise made with ReserveSwap.
+//----------------------------------------------------------------------
+
+void Pager::UnreserveSwap(int pages) {
+    numReserved -= pages;
+    ASSERT(numReserved >= 0);
+}
+
+//----------------------------------------------------------------------
+// Pager::AllocSwap
+// 	Take a free sector of the swap area.  There always is one, since
+//	a space never uses more than it reserved.
+//----------------------------------------------------------------------
+
+int Pager::AllocSwap() {
+    int sector = swapMap->FindAndSet();
+
+    ASSERT(sector != -1);
+    return sector;
+}
+
+//----------------------------------------------------------------------
+// Pager::FreeSwap
+// 	Give back a sector taken with AllocSwap.
+//----------------------------------------------------------------------
+
+void Pager::FreeSwap(int sector) {
+    swapMap->Clear(sector);
+}
+
+//----------------------------------------------------------------------
+// Pager::ReadSwap
+// 	Read swap sector "sector" into "frame".  The thread sleeps until
+//	the disk is done.
+//----------------------------------------------------------------------
+
+void Pager::ReadSwap(int sector, int frame) {
+    kernel->stats->numSwapReads++;
+    kernel->synchDisk->ReadSector(sector, &(kernel->machine->mainMemory[frame * PageSize]));
+}
+
+//----------------------------------------------------------------------
+// Pager::WriteSwap
+// 	Write "frame" to swap sector "sector".  The thread sleeps until
+//	the disk is done.
+//----------------------------------------------------------------------
+
+void Pager::WriteSwap(int sector, int frame) {
+    kernel->stats->numSwapWrites++;
+    kernel->synchDisk->WriteSector(sector, &(kernel->machine->mainMemory[frame * PageSize]));
+}
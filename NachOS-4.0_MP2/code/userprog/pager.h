@@ -0,0 +1,163 @@
+// pager.h
+//	Data structures for demand paging.
+//
+//	The pages of a user program start out invalid, and are brought
+//	into a physical frame the first time they are touched: from the
+//	executable, from the swap area, or as zeros.  When no frame is
+//	free, a replacement policy picks a frame to take away; its page
+//	is written to the swap area first if it was changed.
+//
+//	Pages that come from the executable (code, read-only data and
+//	initialized data) are shared by all the address spaces running
+//	the same executable, found by its name and the page number: a
+//	page fault maps the frame another space already loaded, and the
+//	frame counts how many map it.  The shared pages are read only.
+//	Writing to one, except to read-only data, makes a private copy
+//	for the space that wrote (copy on write).
+//
+//	The other pages (uninitialized data and the stack) are filled
+//	with zeros when they are first touched; pages that are never
+//	touched cost nothing.
+//
+//	The swap area is the simulated disk, one page per sector.  With
+//	the stub file system nothing else uses the disk.  Each address
+//	space reserves room for all of its pages when it is loaded, so
+//	taking a frame away never runs out of swap; but a page only gets
+//	a particular sector the first time it is written out.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "bitmap.h"
+#include "copyright.h"
+#include "disk.h"
+#include "frametable.h"
+#include "list.h"
+#include "machine.h"
+
+class AddrSpace;
+class Lock;
+
+#define SwapSectors NumSectors  // pages the swap area can hold
+
+// The following class defines how a frame to take away is chosen,
+// from the frames in "table" that are not pinned.
+
+class ReplacePolicy {
+   public:
+    ReplacePolicy(FrameTable *table) { frames = table; }
+    virtual ~ReplacePolicy() {}
+
+    virtual int Victim() = 0;  // Choose a frame to take away;
+                               // every frame is in use
+
+   protected:
+    FrameTable *frames;
+
+    TranslationEntry *Candidate(int frame);
+    // The page table entry of the page in
+    // "frame", NULL if it is pinned
+};
+
+// First in, first out: the frame loaded longest ago.
+
+class FifoReplace : public ReplacePolicy {
+   public:
+    FifoReplace(FrameTable *table) : ReplacePolicy(table) {}
+
+    int Victim();
+};
+
+// Clock, or second chance: go round the frames, clearing use bits,
+// until one is found that was not used since the last time round.
+
+class ClockReplace : public ReplacePolicy {
+   public:
+    ClockReplace(FrameTable *table);
+
+    int Victim();
+
+   protected:
+    int hand;  // next frame to look at
+};
+
+// An approximation of least recently used, from the use and dirty
+// bits: the clock, but a frame not used lately that is also clean
+// goes first, since it need not be written to swap.
+
+class LruReplace : public ClockReplace {
+   public:
+    LruReplace(FrameTable *table) : ClockReplace(table) {}
+
+    int Victim();
+};
+
+// The following class defines an executable that address spaces are
+// running, and the frames holding its shared pages.
+
+class SharedImage {
+   public:
+    SharedImage(char *fileName, int pages);
+    ~SharedImage();
+
+    char *name;                 // the executable
+    int numPages;               // pages of a space running it
+    int *frame;                 // frame holding each shared page,
+                                // -1 if it is not in memory
+    List<AddrSpace *> *spaces;  // the spaces running it
+};
+
+// The following class defines the pager: bringing pages into frames
+// (see frametable.h), sharing them, and the sectors of the swap area.
+
+class Pager {
+   public:
+    Pager(char *policyName);  // policyName is "fifo", "clock" or
+                              // "lru", or NULL for the clock
+    ~Pager();
+
+    void PageIn(AddrSpace *space, int vpn);
+    // Bring page "vpn" of "space" into a
+    // frame, after a page fault
+    void Release(AddrSpace *space);
+    // Free the frames "space" is using
+    SharedImage *Attach(AddrSpace *space, char *fileName);
+    // "space" is running "fileName"; share
+    // its pages with other spaces doing so
+    void CopyOnWrite(AddrSpace *space, int vpn);
+    // Give "space" its own copy of shared
+    // page "vpn", which it is writing
+
+    bool ReserveSwap(int pages);  // Promise room for "pages" pages;
+                                  // FALSE if there is not enough
+    void UnreserveSwap(int pages);
+    int AllocSwap();  // Take a swap sector, out of what
+                      // was reserved
+    void FreeSwap(int sector);
+
+    void ReadSwap(int sector, int frame);   // Swap sector -> frame
+    void WriteSwap(int sector, int frame);  // Frame -> swap sector
+
+   private:
+    ReplacePolicy *policy;
+    Lock *lock;  // one page fault at a time
+    Bitmap *swapMap;  // swap sectors in use
+    int numReserved;  // swap sectors promised to address spaces
+    List<SharedImage *> *images;  // executables being run
+
+    void Load(AddrSpace *space, int vpn);
+    // PageIn, with the lock held
+    int GetFrame(AddrSpace *space, int vpn);
+    // Find a free frame for a page, or take
+    // one away; it is returned pinned
+    void Unshare(int frame);  // Take a shared frame away from
+                              // every space mapping it
+    void Leave(int frame, AddrSpace *space);
+    // "space" stops mapping a shared frame
+};
+
+#endif  // PAGER_H
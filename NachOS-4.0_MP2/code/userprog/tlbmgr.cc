@@ -0,0 +1,281 @@
+// tlbmgr.cc
+//	Routines for managing the TLB: loading it on a miss, keeping it
+//	consistent with the page tables, and counting how well each
+//	address space does with it.  See tlbmgr.h.
+//
+//	None of these routines enable interrupts, so they do not have to
+//	worry about another thread changing the TLB under them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "tlbmgr.h"
+
+#include "addrspace.h"
+#include "copyright.h"
+#include "main.h"
+#include "pager.h"
+
+//----------------------------------------------------------------------
+// TlbManager::TlbManager
+// 	Initialize the management of the TLB; no address space yet.
+//
+//	"policyName" -- how to choose the entry to replace on a miss, as
+//		given with -tr, or NULL for LRU
+//----------------------------------------------------------------------
+
+TlbManager::TlbManager(char *policyName) {
+    Machine *machine = kernel->machine;
+
+    ASSERT(machine->tlb != NULL);
+    if (policyName == NULL || strcmp(policyName, "lru") == 0) {
+        policy = TlbLru;
+    } else if (strcmp(policyName, "fifo") == 0) {
+        policy = TlbFifo;
+    } else if (strcmp(policyName, "random") == 0) {
+        policy = TlbRandom;
+    } else {
+        cerr << "Unknown TLB replacement policy " << policyName << "\n";
+        ASSERTNOTREACHED();
+    }
+    loadTime = new int[machine->tlbSize];
+    for (int i = 0; i < machine->tlbSize; i++)
+        loadTime[i] = 0;
+    numLoads = 0;
+    numSpaces = 0;
+    current = -1;
+    lastHits = lastMisses = 0;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::~TlbManager
+// 	De-allocate the TLB management.
+//----------------------------------------------------------------------
+
+TlbManager::~TlbManager() {
+    for (int i = 0; i < numSpaces; i++)
+        delete usage[i];
+    delete[] loadTime;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::NewSpace
+// 	Give a new address space the next ASID, and start counting its
+//	TLB hits and misses.
+//
+//	"space" -- the address space
+//	"name" -- the program loaded into it, for Print
+//----------------------------------------------------------------------
+
+int TlbManager::NewSpace(AddrSpace *space, char *name) {
+    TlbUsage *u;
+
+    ASSERT(numSpaces < NumASIDs);
+    u = new TlbUsage;
+    strncpy(u->name, name, TlbNameLen);
+    u->name[TlbNameLen] = '\0';
+    u->space = space;
+    u->hits = u->misses = 0;
+    usage[numSpaces] = u;
+    return numSpaces++;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::EndSpace
+// 	An address space is going away.  Drop its TLB entries, without
+//	copying their bits back, since its page table is going away too.
+//----------------------------------------------------------------------
+
+void TlbManager::EndSpace(int asid) {
+    Machine *machine = kernel->machine;
+
+    if (asid == current)
+        Charge();
+    for (int i = 0; i < machine->tlbSize; i++) {
+        if (machine->tlb[i].valid && machine->tlb[i].asid == asid)
+            machine->tlb[i].valid = FALSE;
+    }
+    usage[asid]->space = NULL;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::SwitchTo
+// 	An address space is about to run: charge the TLB lookups so far
+//	to the one that ran before, and tell the machine which entries
+//	to use.  Nothing is flushed.
+//----------------------------------------------------------------------
+
+void TlbManager::SwitchTo(int asid) {
+    Charge();
+    current = asid;
+    kernel->machine->asid = asid;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::Charge
+// 	Add the TLB hits and misses since the last call to the address
+//	space that was running.
+//----------------------------------------------------------------------
+
+void TlbManager::Charge() {
+    Statistics *stats = kernel->stats;
+
+    if (current != -1) {
+        usage[current]->hits += stats->numTLBHits - lastHits;
+        usage[current]->misses += stats->numTLBMisses - lastMisses;
+    }
+    lastHits = stats->numTLBHits;
+    lastMisses = stats->numTLBMisses;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::Refill
+// 	Handle a TLB miss on page "vpn" of "space": load its page table
+//	entry into a free TLB entry, or in place of the one the policy
+//	chooses.  If the page is not in memory, bring it in first.
+//
+//	Return FALSE if "vpn" is not a page of "space"; the page table
+//	is not looked at by the machine, so this is where an address
+//	out of range is caught.
+//----------------------------------------------------------------------
+
+bool TlbManager::Refill(AddrSpace *space, int vpn) {
+    Machine *machine = kernel->machine;
+    TranslationEntry *pte, *e;
+    int i;
+
+    if (vpn < 0 || vpn >= space->NumPages())
+        return FALSE;
+    pte = space->GetEntry(vpn);
+    while (!pte->valid)  // a real page fault; PageIn may let
+                         // another thread run, and take it away
+        kernel->pager->PageIn(space, vpn);
+
+    for (i = 0; i < machine->tlbSize; i++) {
+        if (!machine->tlb[i].valid)
+            break;
+    }
+    if (i == machine->tlbSize) {
+        i = Victim();
+        WriteBack(&machine->tlb[i]);
+    }
+    DEBUG(dbgAddr, "TLB miss on page " << vpn << ", into entry " << i);
+
+    e = &machine->tlb[i];
+    e->virtualPage = vpn;
+    e->physicalPage = pte->physicalPage;
+    e->readOnly = pte->readOnly;
+    e->use = FALSE;
+    e->dirty = FALSE;
+    e->asid = space->GetASID();
+    e->valid = TRUE;
+    loadTime[i] = ++numLoads;
+    machine->tlbLastUse[i] = kernel->stats->numTLBHits;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::Victim
+// 	Return the TLB entry to replace; every entry is valid.
+//----------------------------------------------------------------------
+
+int TlbManager::Victim() {
+    Machine *machine = kernel->machine;
+    int victim = 0;
+
+    switch (policy) {
+        case TlbRandom:
+            return RandomNumber() % machine->tlbSize;
+        case TlbFifo:
+            for (int i = 1; i < machine->tlbSize; i++) {
+                if (loadTime[i] < loadTime[victim])
+                    victim = i;
+            }
+            return victim;
+        case TlbLru:
+            for (int i = 1; i < machine->tlbSize; i++) {
+                if (machine->tlbLastUse[i] < machine->tlbLastUse[victim])
+                    victim = i;
+            }
+            return victim;
+    }
+    ASSERTNOTREACHED();
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::WriteBack
+// 	Copy the use and dirty bits of TLB entry "e" to the page table
+//	entry it was loaded from, if its address space is still there.
+//----------------------------------------------------------------------
+
+void TlbManager::WriteBack(TranslationEntry *e) {
+    TranslationEntry *pte;
+
+    if (!e->valid || usage[e->asid]->space == NULL)
+        return;
+    pte = usage[e->asid]->space->GetEntry(e->virtualPage);
+    pte->use = pte->use || e->use;
+    pte->dirty = pte->dirty || e->dirty;
+}
+
+//----------------------------------------------------------------------
+// TlbManager::Invalidate
+// 	The pager is taking the frame of page "vpn" of "space" away.
+//	Copy the bits of its TLB entry, if it has one, so the pager sees
+//	whether the page was changed, and drop the entry.
+//----------------------------------------------------------------------
+
+void TlbManager::Invalidate(AddrSpace *space, int vpn) {
+    Machine *machine = kernel->machine;
+    int asid = space->GetASID();
+
+    for (int i = 0; i < machine->tlbSize; i++) {
+        TranslationEntry *e = &machine->tlb[i];
+
+        if (e->valid && e->asid == asid && e->virtualPage == vpn) {
+            WriteBack(e);
+            e->valid = FALSE;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// TlbManager::Sync
+// 	Copy the use and dirty bits of every TLB entry to the page
+//	tables, for the pager to choose a frame by.  The use bits in the
+//	TLB are cleared, so that a page table use bit the pager clears
+//	is only set again if the page is used again.
+//----------------------------------------------------------------------
+
+void TlbManager::Sync() {
+    Machine *machine = kernel->machine;
+
+    for (int i = 0; i < machine->tlbSize; i++) {
+        WriteBack(&machine->tlb[i]);
+        machine->tlb[i].use = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// TlbManager::Print
+// 	Print the TLB hits, misses and hit rate of each address space,
+//	including the ones that are gone.
+//----------------------------------------------------------------------
+
+void TlbManager::Print() {
+    static const char *policyNames[] = {"random", "fifo", "lru"};
+
+    Charge();
+    cout << "TLB: " << kernel->machine->tlbSize << " entries, "
+         << policyNames[policy] << " replacement\n";
+    for (int i = 0; i < numSpaces; i++) {
+        TlbUsage *u = usage[i];
+        int lookups = u->hits + u->misses;
+
+        cout << "  asid " << i << " " << u->name << ": hits " << u->hits
+             << ", misses " << u->misses << ", hit rate "
+             << (lookups == 0 ? 0.0 : 100.0 * u->hits / lookups) << "%\n";
+    }
+}
@@ -0,0 +1,93 @@
+// tlbmgr.h
+//	Data structures for running user programs with a software-loaded
+//	TLB instead of a linear page table (see machine.h).
+//
+//	With -tlb, the machine looks every user address up in the TLB
+//	only, and a miss is a PageFaultException.  The kernel then loads
+//	the page table entry into the TLB, after bringing the page in if
+//	it is not in memory (see pager.h).  The entry to replace is chosen
+//	by -tr: random, fifo or lru.
+//
+//	Each address space gets an address space identifier (ASID), and
+//	each TLB entry is tagged with the ASID of its space; the machine
+//	only uses the entries of the running program.  So a context switch
+//	does not flush the TLB, and a program that runs again may find
+//	its entries still there.  ASIDs are not reused.
+//
+//	The machine sets the use and dirty bits in the TLB entry, not in
+//	the page table.  They are copied to the page table when the entry
+//	is replaced, and before the pager chooses a frame to take away.
+//	When the pager takes a frame away, its TLB entry is removed.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TLBMGR_H
+#define TLBMGR_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class AddrSpace;
+
+#define NumASIDs 256      // address spaces that can be created
+#define TlbNameLen 31     // longest program name kept
+
+enum TlbPolicy { TlbRandom, TlbFifo, TlbLru };
+
+// The following class defines the TLB use of one address space, kept
+// after it goes away so it can be printed when Nachos halts.
+
+class TlbUsage {
+   public:
+    char name[TlbNameLen + 1];  // the program
+    AddrSpace *space;           // NULL once it is gone
+    int hits;                   // its addresses found in the TLB
+    int misses;                 // and not found there
+};
+
+// The following class defines the kernel's management of the TLB.
+
+class TlbManager {
+   public:
+    TlbManager(char *policyName);  // policyName is "random", "fifo"
+                                   // or "lru", or NULL for lru
+    ~TlbManager();
+
+    int NewSpace(AddrSpace *space, char *name);
+    // Give "space" an ASID, and return it
+    void EndSpace(int asid);  // The space is going away; drop
+                              // its entries
+    void SwitchTo(int asid);  // The space is about to run
+
+    bool Refill(AddrSpace *space, int vpn);
+    // Load page "vpn" of "space" into the
+    // TLB after a miss; FALSE if there is
+    // no such page
+    void Invalidate(AddrSpace *space, int vpn);
+    // The page's frame is being taken away
+    void Sync();  // Copy the use and dirty bits to the
+                  // page tables, clearing the use bits
+
+    void Print();  // Hit rate of each address space
+
+   private:
+    TlbPolicy policy;      // how to choose the entry to replace
+    TlbUsage *usage[NumASIDs];  // indexed by ASID
+    int numSpaces;         // ASIDs given out so far
+    int current;           // ASID charged with TLB lookups
+    int lastHits;          // kernel->stats counts, when
+    int lastMisses;        // "current" was last charged
+    int *loadTime;         // when each entry was loaded, for fifo
+    int numLoads;          // entries loaded so far
+
+    int Victim();  // Choose an entry to replace
+    void WriteBack(TranslationEntry *e);
+    // Copy the use and dirty bits of "e"
+    // to its page table entry
+    void Charge();  // Charge the lookups since last time
+                    // to "current"
+};
+
+#endif  // TLBMGR_H
@@ -24,6 +24,7 @@
 
 #include "copyright.h"
 #include "main.h"
+#include "synchconsole.h"
 
 // String definitions for debugging messages
 
@@ -150,9 +151,11 @@ void Interrupt::OneTick() {
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
         stats->systemTicks += SystemTick;
+        kernel->currentThread->account_Ticks(SystemTick, FALSE);
     } else {
         stats->totalTicks += UserTick;
         stats->userTicks += UserTick;
+        kernel->currentThread->account_Ticks(UserTick, TRUE);
     }
     DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
@@ -166,6 +169,7 @@ void Interrupt::OneTick() {
                                  // for a context switch, ok to do it now
         yieldOnReturn = FALSE;
         status = SystemMode;  // yield is a kernel routine
+        kernel->currentThread->preempted = TRUE;
         kernel->currentThread->Yield();
         status = oldStatus;
     }
@@ -197,10 +201,18 @@ void Interrupt::YieldOnReturn() {
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
+//
+//	If threads are asleep in Alarm::WaitUntil, first skip ahead
+//	towards the time the first of them wakes up.
 //----------------------------------------------------------------------
 void Interrupt::Idle() {
+    int wakeup = kernel->alarm->NextWakeup();
+
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
+    if (wakeup >= 0) {
+        FastForward(wakeup);
+    }
     DEBUG(dbgTraCode, "In Interrupt::Idle, into CheckIfDue, " << kernel->stats->totalTicks);
     if (CheckIfDue(TRUE)) {  // check for any pending interrupts
         DEBUG(dbgTraCode, "In Interrupt::Idle, return true from CheckIfDue, " << kernel->stats->totalTicks);
@@ -221,6 +233,66 @@ void Interrupt::Idle() {
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::FastForward
+// 	Called when idle, with a thread asleep until "wakeup".  Until the
+//	timer interrupt that wakes it up, the console keeps polling for
+//	input every tick, so idling would only advance time one tick at
+//	a time.  Unless a thread is blocked reading the console, neither
+//	a poll nor a timer interrupt before then can make a thread ready.
+//	So advance the clock straight to the first timer interrupt at or
+//	after "wakeup", and let the interrupts due before it go off once,
+//	late.
+//
+//	Stop early if any other interrupt (a disk or a console write,
+//	say) is due before then, or a console poll while a reader is
+//	waiting for input, and never go past a time the timer was not
+//	due, so time slices keep their phase.
+//----------------------------------------------------------------------
+void Interrupt::FastForward(int wakeup) {
+    ListIterator<PendingInterrupt *> it(pending);
+    Statistics *stats = kernel->stats;
+    bool reading = kernel->synchConsoleIn != NULL &&
+                   kernel->synchConsoleIn->IsWaiting();
+    int timerDue = -1, stop = -1;
+    int target;
+
+    for (; !it.IsDone(); it.Next()) {
+        PendingInterrupt *next = it.Item();
+
+        if (next->type == TimerInt) {
+            if (timerDue < 0) {
+                timerDue = next->when;
+            }
+        } else if (next->type != ConsoleReadInt || reading) {
+            stop = next->when;  // the list is sorted: the first one
+            break;
+        }
+    }
+    if (timerDue < 0) {
+        return;  // no timer, so nothing to wake the thread
+    }
+
+    target = timerDue;
+    if (wakeup > target) {
+        target += divRoundUp(wakeup - target, TimerTicks) * TimerTicks;
+    }
+    if (stop >= 0 && stop < target) {
+        if (stop < timerDue) {
+            target = stop;
+        } else {
+            target = timerDue + (stop - timerDue) / TimerTicks * TimerTicks;
+        }
+    }
+    if (target <= stats->totalTicks) {
+        return;
+    }
+
+    DEBUG(dbgInt, "Machine idle until " << target << ", for a thread waking up at " << wakeup);
+    stats->idleTicks += target - stats->totalTicks;
+    stats->totalTicks = target;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 // 	Shut down Nachos cleanly, printing out performance statistics.
@@ -231,6 +303,12 @@ void Interrupt::Halt() {
     cout << "This is halt\n";
     kernel->stats->Print();
 #endif
+    if (kernel->schedStats) {
+        kernel->scheduler->PrintStats();
+    }
+    if (kernel->threadStats != NULL) {
+        kernel->scheduler->PrintAccounts(kernel->threadStats);
+    }
     delete kernel;  // Never returns.
 }
 /*
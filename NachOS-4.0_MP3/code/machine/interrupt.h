@@ -133,6 +133,9 @@ class Interrupt {
     void OneTick();  // Advance simulated time
 
    private:
+    void FastForward(int wakeup);
+    // Idle: skip ahead to the timer
+    // interrupt due at "wakeup"
     IntStatus level;  // are interrupts enabled or disabled?
     SortedList<PendingInterrupt *> *pending;
     // the list of interrupts scheduled
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# Run the hw3 test programs under every scheduling policy (see
+# threads/schedpolicy.h), and print what "-ss" reports when Nachos
+# halts: throughput, mean turnaround and response time, and context
+# switches.
+#
+# The hw4t* programs need the file system of MP4, which this copy of
+# Nachos is built without, so they are not run here.
+
+POLICIES="fifo rr mlfq cfs lottery"
+
+CASES=(\
+"-ep hw3t1 0 -ep hw3t2 0" \
+"-ep hw3t1 50 -ep hw3t2 50" \
+"-ep hw3t1 50 -ep hw3t2 90" \
+"-ep hw3t1 100 -ep hw3t2 100" \
+"-ep hw3t1 40 -ep hw3t2 55" \
+"-ep hw3t1 40 -ep hw3t2 90" \
+"-ep hw3t1 90 -ep hw3t2 100" \
+"-ep hw3t1 60 -ep hw3t3 50" \
+"-ep hw3t1 10 -ep hw3t2 60 -ep hw3t3 110" \
+)
+
+TIMEOUT="timeout 10s"
+
+for policy in $POLICIES; do
+    echo -e "===== Policy: $policy ====="
+    for ((i=0; i<${#CASES[@]}; i++)); do
+        echo -e "--- ${CASES[$i]}"
+        $TIMEOUT ../build.linux/nachos -sched $policy -ss -ee ${CASES[$i]} \
+            | grep -A1 "^Scheduler "
+    done
+done
+
+exit 0
@@ -0,0 +1,12 @@
+#include "syscall.h"
+
+int
+main()
+{
+	int n;
+	for (n = 1; n < 5; ++n) {
+		PrintInt(n);
+		Sleep(1000);
+	}
+	Exit(0);
+}
@@ -1,8 +1,7 @@
 // alarm.cc
 //	Routines to use a hardware timer device to provide a
-//	software alarm clock.  For now, we just provide time-slicing.
-//
-//	Not completely implemented.
+//	software alarm clock: time-slicing, and putting threads to
+//	sleep for a while.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -11,6 +10,22 @@
 #include "copyright.h"
 #include "alarm.h"
 #include "main.h"
+#include "schedpolicy.h"
+
+//----------------------------------------------------------------------
+// cmp_WakeTick
+// 	Order of the sleeping threads: the first due to wake up first,
+//	then by ID.
+//----------------------------------------------------------------------
+
+static int
+cmp_WakeTick(Thread *a, Thread *b)
+{
+    if (a->wake_Tick < b->wake_Tick) return -1;
+    else if (a->wake_Tick > b->wake_Tick) return 1;
+    else if (a->getID() > b->getID()) return 1;
+    else return -1;
+}
 
 //----------------------------------------------------------------------
 // Alarm::Alarm
@@ -23,6 +38,19 @@
 Alarm::Alarm(bool doRandom)
 {
     timer = new Timer(doRandom, this);
+    sleepers = new ReadyHeap(cmp_WakeTick);	// asleep, so in no ready heap
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+//      De-allocate the alarm clock.  Threads still asleep are left to
+//	the kernel to clean up.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    delete timer;
+    delete sleepers;
 }
 
 //----------------------------------------------------------------------
@@ -39,8 +67,9 @@ Alarm::Alarm(bool doRandom)
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
-//	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//	First wake up the threads whose time has come, then time-slice.
+//	Only need to time slice if we're currently running something
+//	(in other words, not idle).
 //----------------------------------------------------------------------
 
 void 
@@ -48,31 +77,59 @@ Alarm::CallBack()
 {
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
-    Scheduler *scheduler = kernel->scheduler;
 
-    // update priority
-    scheduler->UpdatePriority();
+    while (!sleepers->IsEmpty()
+           && sleepers->Front()->wake_Tick <= kernel->stats->totalTicks) {
+        Thread *thread = sleepers->RemoveFront();
 
-    int label = 0;
-
-    if(kernel->currentThread->get_Priority() < 50){
-        if(scheduler->L1_Empty() == 0) label = 1;
-        if(scheduler->L2_Empty() == 0) label = 1;
-        if(kernel->stats->totalTicks - kernel->currentThread->burst_Start_Time >= 100) label = 1;
-    }
-
-    else if(kernel->currentThread->get_Priority() >= 50 && kernel->currentThread->get_Priority() < 100){
-        if(scheduler->L1_Empty() == 0) label = 1;
+        DEBUG(dbgThread, "Waking up thread: " << thread->getName());
+        kernel->scheduler->ReadyToRun(thread);
     }
 
-    else {
-        int current_remain = kernel->currentThread->get_Burst_Time() - kernel->currentThread->get_Use_Time() - (kernel->stats->totalTicks - kernel->currentThread->burst_Start_Time);
-        if(scheduler->L1_Empty() == 0 && current_remain > scheduler->L1_Front_Remain()) label = 1;
-    }
-
-    if(label == 1) {
+    // the scheduling policy decides whether to preempt (see schedpolicy.cc)
+    if (kernel->scheduler->Tick()) {
         if (status != IdleMode) {
             interrupt->YieldOnReturn();
         }
     }
 }
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+//	Put the current thread to sleep for at least "x" ticks.  It is
+//	off the ready queue until then, and is woken up by the first
+//	timer interrupt at or after tick now + x.
+//
+//	"x" -- how long to sleep; the thread does not sleep if it is
+//		not positive
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int x)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    Thread *thread = kernel->currentThread;
+
+    if (x > 0) {
+        thread->wake_Tick = kernel->stats->totalTicks + x;
+        DEBUG(dbgThread, "Thread " << thread->getName()
+              << " sleeps until tick " << thread->wake_Tick);
+        sleepers->Insert(thread);
+        thread->Sleep(FALSE);
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::NextWakeup
+//	Return the tick the first sleeping thread is due to wake up, or
+//	-1 if no thread is asleep.  Used by Interrupt::Idle to skip ahead.
+//----------------------------------------------------------------------
+
+int
+Alarm::NextWakeup()
+{
+    if (sleepers->IsEmpty())
+        return -1;
+    return sleepers->Front()->wake_Tick;
+}
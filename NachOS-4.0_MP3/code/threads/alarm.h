@@ -8,7 +8,10 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
-//	NOTE: this abstraction is not completely implemented.
+//	A thread that waits is taken off the ready queue, and kept in a
+//	heap by the time it is due to wake up; at each timer interrupt,
+//	the threads at the front of the heap whose time has come are
+//	put back on the ready queue.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -22,18 +25,22 @@
 #include "timer.h"
 #include "utility.h"
 
+class ReadyHeap;
+
 // The following class defines a software alarm clock.
 class Alarm : public CallBackObj {
    public:
     Alarm(bool doRandomYield);  // Initialize the timer, and callback
                                 // to "toCall" every time slice.
-    ~Alarm() { delete timer; }
+    ~Alarm();
 
-    void WaitUntil(int x);  // suspend execution until time > now + x
-                            // this method is not yet implemented
+    void WaitUntil(int x);  // suspend execution until time >= now + x
+    int NextWakeup();       // when the first sleeping thread is due
+                            // to wake up; -1 if none is asleep
 
    private:
-    Timer *timer;  // the hardware timer device
+    Timer *timer;          // the hardware timer device
+    ReadyHeap *sleepers;   // threads in WaitUntil, by wake_Tick
 
     void CallBack();  // called when the hardware
                       // timer generates an interrupt
@@ -30,6 +30,10 @@ Kernel::Kernel(int argc, char **argv) {
     debugUserProg = FALSE;
     execExit = FALSE;
     priorityFlag = FALSE;    // TODO
+    schedPolicy = NULL;  // default is the MP3 multi-level queue
+    schedStats = FALSE;
+    threadStats = NULL;
+    execRunningNum = 0;
     consoleIn = NULL;   // default is stdin
     consoleOut = NULL;  // default is stdout
 #ifndef FILESYS_STUB
@@ -82,6 +86,20 @@ Kernel::Kernel(int argc, char **argv) {
             cout << "Partial usage: nachos [-nf]\n";
 #endif
             cout << "Partial usage: nachos [-n #] [-m #]\n";
+            cout << "Partial usage: nachos [-sched fifo|rr|mlfq|cfs|lottery] [-ss]\n";
+            cout << "Partial usage: nachos [-ts csv|json]\n";
+        } else if (strcmp(argv[i], "-sched") == 0) {
+            ASSERT(i + 1 < argc);
+            schedPolicy = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-ss") == 0) {
+            schedStats = TRUE;
+        } else if (strcmp(argv[i], "-ts") == 0) {
+            ASSERT(i + 1 < argc);
+            threadStats = argv[i + 1];
+            ASSERT(strcmp(threadStats, "csv") == 0 ||
+                   strcmp(threadStats, "json") == 0);
+            i++;
         } else if (strcmp(argv[i], "-ep") == 0) {      
             priorityFlag = TRUE;
             execfile[++execfileNum]= argv[++i];
@@ -107,7 +125,7 @@ void Kernel::Initialize() {
 
     stats = new Statistics();        // collect statistics
     interrupt = new Interrupt;       // start up interrupt handling
-    scheduler = new Scheduler();     // initialize the ready queue
+    scheduler = new Scheduler(schedPolicy);  // initialize the ready queue
     alarm = new Alarm(randomSlice);  // start up time slicing
     machine = new Machine(debugUserProg);
     synchConsoleIn = new SynchConsoleInput(consoleIn);     // input from stdin
@@ -192,6 +210,45 @@ void Kernel::ThreadSelfTest() {
     delete synchList;
 }
 
+//----------------------------------------------------------------------
+// Kernel::SchedulerTest
+//      Measure the scheduler with many ready threads: "numThreads"
+//      threads with priorities spread over all three levels take turns
+//      burning CPU time, and the simulated time until all of them
+//      finish is reported.  Run under "time" to see the host time.
+//----------------------------------------------------------------------
+
+static const int SchedulerTestRounds = 20;
+static Semaphore *schedulerTestDone;
+
+static void
+SchedulerTestHelper(int which)
+{
+    for (int i = 0; i < SchedulerTestRounds; i++) {
+        for (int j = 0; j < (which % 5 + 1) * 10; j++)
+            kernel->interrupt->OneTick();   // time slices happen in here
+        kernel->currentThread->Yield();
+    }
+    schedulerTestDone->V();
+}
+
+void
+Kernel::SchedulerTest(int numThreads) {
+    int start = stats->totalTicks;
+
+    schedulerTestDone = new Semaphore("scheduler test", 0);
+    for (int i = 0; i < numThreads; i++) {
+        Thread *t = new Thread("scheduler test", threadNum++, (i * 37) % 150);
+        t->Fork((VoidFunctionPtr) SchedulerTestHelper, (void *) i);
+    }
+    for (int i = 0; i < numThreads; i++)
+        schedulerTestDone->P();
+    delete schedulerTestDone;
+
+    cout << "Scheduler test: " << numThreads << " threads in "
+         << stats->totalTicks - start << " ticks\n";
+}
+
 //----------------------------------------------------------------------
 // Kernel::ConsoleTest
 //      Test the synchconsole
@@ -295,6 +352,7 @@ int Kernel::Exec(int idx, char *name) {
     }
 
 	t[threadNum]->space = new AddrSpace();
+	execRunningNum++;
 	t[threadNum]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[threadNum]);
 	threadNum++;
 
@@ -43,6 +43,7 @@ class Kernel {
     void ExecAll();
     int Exec(int idx, char *name);
     void ThreadSelfTest();  // self test of threads and synchronization
+    void SchedulerTest(int numThreads);  // time many ready threads
 
     void ConsoleTest();  // interactive console self test
     void NetworkTest();  // interactive 2-machine network test
@@ -75,6 +76,10 @@ class Kernel {
     PostOfficeOutput *postOfficeOut;
     bool execExit;       // exit if all threads are finished
     int execRunningNum;  // number of running threads
+    char *schedPolicy;   // scheduling policy, from -sched
+    bool schedStats;     // print scheduler statistics at halt
+    char *threadStats;   // print per-thread accounts at halt, as
+                         // "csv" or "json"; NULL for none
 
     int hostName;  // machine identifier
 
@@ -7,7 +7,8 @@
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -S <thread count>
+//              -sched <policy> -ss -ts <csv|json>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
@@ -21,6 +22,14 @@
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -S time the scheduler with many threads, then halt
+//       (see Kernel::SchedulerTest)
+//    -sched chooses the scheduling policy: fifo, rr, mlfq (the default),
+//       cfs or lottery (see schedpolicy.h)
+//    -ss prints scheduler statistics when Nachos halts
+//    -ts prints, when Nachos halts, where the time of each thread went:
+//       CPU and ready queue ticks, preemptions, and ticks at each level
+//       of the multi-level queue (see Scheduler::PrintAccounts)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -162,6 +171,7 @@ int main(int argc, char **argv) {
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    int schedulerTestThreads = 0;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
@@ -191,6 +201,10 @@ int main(int argc, char **argv) {
             consoleTestFlag = TRUE;
         } else if (strcmp(argv[i], "-N") == 0) {
             networkTestFlag = TRUE;
+        } else if (strcmp(argv[i], "-S") == 0) {
+            ASSERT(i + 1 < argc);
+            schedulerTestThreads = atoi(argv[i + 1]);
+            i++;
         }
 #ifndef FILESYS_STUB
         else if (strcmp(argv[i], "-cp") == 0) {
@@ -215,7 +229,7 @@ int main(int argc, char **argv) {
         else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-            cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+            cout << "Partial usage: nachos [-K] [-C] [-N] [-S threads]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
@@ -244,6 +258,10 @@ int main(int argc, char **argv) {
     if (networkTestFlag) {
         kernel->NetworkTest();  // two-machine test of the network
     }
+    if (schedulerTestThreads > 0) {
+        kernel->SchedulerTest(schedulerTestThreads);  // time the scheduler
+        kernel->interrupt->Halt();
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL) {
@@ -0,0 +1,692 @@
+// schedpolicy.cc
+//	Routines for the scheduling policies, and the heap of ready
+//	threads some of them use.  See schedpolicy.h.
+//
+// 	These routines assume that interrupts are already disabled.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "schedpolicy.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// cmp_BurstTime, cmp_Priority, cmp_WaitStart, cmp_ReadySeq
+// 	MP3: orders of the L1 and L2 ready queues, of the aging heaps, and
+//	of arrival in the ready queue.  Threads with the same remaining
+//	burst time, priority, or start of wait, go by ID.
+//----------------------------------------------------------------------
+
+int cmp_BurstTime(Thread *a, Thread *b){
+    double at = a->get_Burst_Time() - a->get_Use_Time();
+    double bt = b->get_Burst_Time() - b->get_Use_Time();
+
+    if(at < 0) at = 0;
+    if(bt < 0) bt = 0;
+
+    if(at > bt) return 1;
+    else if(at < bt) return -1;
+    else if(a->getID() > b->getID()) return 1;
+    else return -1;
+}
+
+int cmp_Priority(Thread *a, Thread *b){
+    int ap = a->get_Priority();
+    int bp = b->get_Priority();
+
+    if(ap > bp) return -1;
+    else if(ap < bp) return 1;
+    else if(a->getID() > b->getID()) return 1;
+    else return -1;
+}
+
+int cmp_WaitStart(Thread *a, Thread *b){
+    if(a->wait_Start_Time < b->wait_Start_Time) return -1;
+    else if(a->wait_Start_Time > b->wait_Start_Time) return 1;
+    else if(a->getID() > b->getID()) return 1;
+    else return -1;
+}
+
+int cmp_ReadySeq(Thread *a, Thread *b){
+    return a->ready_Seq - b->ready_Seq;
+}
+
+//----------------------------------------------------------------------
+// ReadyHeap::ReadyHeap
+// 	Initialize an empty heap of ready threads.
+//
+//	"comp" is the order of the heap: it returns a negative number
+//	if the first thread should come out before the second.
+//	"slotField" is the field of Thread that keeps its slot.
+//----------------------------------------------------------------------
+
+ReadyHeap::ReadyHeap(int (*comp)(Thread *, Thread *), int Thread::*slotField)
+{
+    compare = comp;
+    slot = slotField;
+    maxItems = 16;
+    items = new Thread *[maxItems];
+    numItems = 0;
+}
+
+ReadyHeap::~ReadyHeap()
+{
+    delete [] items;
+}
+
+//----------------------------------------------------------------------
+// ReadyHeap::Insert
+// 	Put a thread in the heap, growing the heap if it is full.
+//----------------------------------------------------------------------
+
+void
+ReadyHeap::Insert(Thread *thread)
+{
+    ASSERT(thread->*slot == -1);
+    if (numItems == maxItems) {
+        Thread **bigger = new Thread *[maxItems * 2];
+        for (int i = 0; i < numItems; i++)
+            bigger[i] = items[i];
+        delete [] items;
+        items = bigger;
+        maxItems *= 2;
+    }
+    Place(numItems++, thread);
+    SiftUp(numItems - 1);
+}
+
+//----------------------------------------------------------------------
+// ReadyHeap::RemoveFront
+// 	Take the smallest thread out of the heap and return it.
+//----------------------------------------------------------------------
+
+Thread *
+ReadyHeap::RemoveFront()
+{
+    Thread *thread = Front();
+
+    Remove(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// ReadyHeap::Remove
+// 	Take "thread" out of the heap: the last thread fills its slot,
+//	and is moved up or down to where it belongs.
+//----------------------------------------------------------------------
+
+void
+ReadyHeap::Remove(Thread *thread)
+{
+    int i = thread->*slot;
+
+    ASSERT(i >= 0 && i < numItems && items[i] == thread);
+    thread->*slot = -1;
+    numItems--;
+    if (i == numItems)
+        return;
+    Place(i, items[numItems]);
+    SiftUp(i);
+    SiftDown(items[i]->*slot);
+}
+
+void
+ReadyHeap::Place(int i, Thread *thread)
+{
+    items[i] = thread;
+    thread->*slot = i;
+}
+
+void
+ReadyHeap::SiftUp(int i)
+{
+    Thread *thread = items[i];
+
+    while (i > 0 && compare(thread, items[(i - 1) / 2]) < 0) {
+        Place(i, items[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    Place(i, thread);
+}
+
+void
+ReadyHeap::SiftDown(int i)
+{
+    Thread *thread = items[i];
+    int child;
+
+    while ((child = 2 * i + 1) < numItems) {
+        if (child + 1 < numItems && compare(items[child + 1], items[child]) < 0)
+            child++;
+        if (compare(items[child], thread) >= 0)
+            break;
+        Place(i, items[child]);
+        i = child;
+    }
+    Place(i, thread);
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::MultiLevelPolicy
+// 	Initialize the three levels of ready threads, all empty.
+//----------------------------------------------------------------------
+
+MultiLevelPolicy::MultiLevelPolicy()
+{ 
+    readyList_L1 = new ReadyHeap(cmp_BurstTime); 
+    for (int i = 0; i < L2_Buckets; i++)
+        readyList_L2[i] = new ReadyHeap(cmp_Priority);
+    readyList_L3 = new ReadyHeap(cmp_ReadySeq);
+    agingList_L1 = new ReadyHeap(cmp_WaitStart, &Thread::aging_Index);
+    agingList_L3 = new ReadyHeap(cmp_WaitStart, &Thread::aging_Index);
+    L2_Mask = 0;
+    levelMask = 0;
+    readyCount = 0;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::~MultiLevelPolicy
+// 	De-allocate the ready queues.
+//----------------------------------------------------------------------
+
+MultiLevelPolicy::~MultiLevelPolicy()
+{ 
+    delete readyList_L1;
+    for (int i = 0; i < L2_Buckets; i++)
+        delete readyList_L2[i];
+    delete readyList_L3;
+    delete agingList_L1;
+    delete agingList_L3;
+} 
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::L2_Bucket
+// 	Return which of the L2 queues "thread" belongs in, from its
+//	priority.
+//----------------------------------------------------------------------
+
+int
+MultiLevelPolicy::L2_Bucket(Thread *thread)
+{
+    int bucket = thread->get_Priority() - L2_Lowest;
+
+    ASSERT(bucket >= 0 && bucket < L2_Buckets);
+    return bucket;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Insert_L2, MultiLevelPolicy::Remove_L2
+// 	Put a thread in, or take it out of, an L2 queue, keeping the
+//	bitmasks of non-empty queues and levels up to date.
+//
+//	"bucket" is the queue the thread is in.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::Insert_L2(Thread *thread)
+{
+    int bucket = L2_Bucket(thread);
+
+    readyList_L2[bucket]->Insert(thread);
+    L2_Mask |= 1ULL << bucket;
+    levelMask |= L2_Bit;
+}
+
+void
+MultiLevelPolicy::Remove_L2(Thread *thread, int bucket)
+{
+    readyList_L2[bucket]->Remove(thread);
+    if (readyList_L2[bucket]->IsEmpty()) {
+        L2_Mask &= ~(1ULL << bucket);
+        if (L2_Mask == 0)
+            levelMask &= ~L2_Bit;
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Enqueue
+// 	Put a ready thread in the level of its priority.
+//----------------------------------------------------------------------
+
+void MultiLevelPolicy::Enqueue (Thread *thread) {
+    thread->ready_Seq = readyCount++;
+
+    if(thread->get_Priority() >= 100) {
+        DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[1]");
+        readyList_L1->Insert(thread);
+        agingList_L1->Insert(thread);
+        levelMask |= L1_Bit;
+    }
+    else if(thread->get_Priority() >= 50) {
+        DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[2]");
+        Insert_L2(thread);
+    }
+    else {
+        DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[3]");
+        readyList_L3->Insert(thread);
+        agingList_L3->Insert(thread);
+        levelMask |= L3_Bit;
+    }
+
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Pick
+// 	Take out the first thread of the highest level that has one.
+//----------------------------------------------------------------------
+
+Thread * MultiLevelPolicy::Pick (){
+    Thread *thread;
+
+    if (levelMask & L1_Bit) {
+        thread = readyList_L1->RemoveFront();
+        agingList_L1->Remove(thread);
+        if (readyList_L1->IsEmpty())
+            levelMask &= ~L1_Bit;
+		DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from queue L[1]");
+        return thread;
+    }
+    else if (levelMask & L2_Bit) {
+        // the highest priority with a thread is the highest bit set
+        int bucket = 63 - __builtin_clzll(L2_Mask);
+        thread = readyList_L2[bucket]->Front();
+        Remove_L2(thread, bucket);
+        DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from queue L[2]");
+		return thread;
+    }
+    else if (levelMask & L3_Bit) {
+        thread = readyList_L3->RemoveFront();
+        agingList_L3->Remove(thread);
+        if (readyList_L3->IsEmpty())
+            levelMask &= ~L3_Bit;
+        DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from queue L[3]");
+		return thread;
+    }
+    else {
+        return NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Print
+// 	Print the ready threads, level by level.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::Print()
+{
+    for (int i = 0; i < readyList_L1->NumInHeap(); i++)
+        ThreadPrint(readyList_L1->Item(i));
+    for (int b = L2_Buckets - 1; b >= 0; b--)
+        for (int i = 0; i < readyList_L2[b]->NumInHeap(); i++)
+            ThreadPrint(readyList_L2[b]->Item(i));
+    for (int i = 0; i < readyList_L3->NumInHeap(); i++)
+        ThreadPrint(readyList_L3->Item(i));
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::UpdatePriority
+// 	MP3: called at every timer interrupt.  Age the ready threads that
+//	have waited Aging_Interval ticks since they were queued or last
+//	aged, and move those that reached a higher level.  The aging heaps
+//	have them at the front, so the other ready threads are not looked
+//	at.  The threads found are aged in the order of their ready queue,
+//	as when every ready thread was checked at each timer interrupt.
+//
+//	L2 threads are never aged: their wait used to be restarted at
+//	every timer interrupt, so it never reached Aging_Interval.  The
+//	main thread (ID 0) is aged but never moved to a higher level.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::UpdatePriority()
+{
+    int now = kernel->stats->totalTicks;
+    SortedList<Thread *> due_L1(cmp_BurstTime);
+    SortedList<Thread *> due_L3(cmp_ReadySeq);
+    Thread *thread;
+
+    while (!agingList_L1->IsEmpty()
+           && now - agingList_L1->Front()->wait_Start_Time >= Aging_Interval)
+        due_L1.Insert(agingList_L1->RemoveFront());
+    while (!due_L1.IsEmpty()) {
+        thread = due_L1.RemoveFront();
+        thread->aging(now - thread->wait_Start_Time);
+        agingList_L1->Insert(thread);
+    }
+
+    while (!agingList_L3->IsEmpty()
+           && now - agingList_L3->Front()->wait_Start_Time >= Aging_Interval)
+        due_L3.Insert(agingList_L3->RemoveFront());
+    while (!due_L3.IsEmpty()) {
+        thread = due_L3.RemoveFront();
+        bool upgrade = thread->aging(now - thread->wait_Start_Time);
+        if(upgrade && thread->getID() > 0) {
+            DEBUG(dbgScheduler, "[C] Tick [" << now << "]: Thread [" << thread->getID() << "] is removed from queue L[2]");
+            readyList_L3->Remove(thread);
+            if (readyList_L3->IsEmpty())
+                levelMask &= ~L3_Bit;
+            kernel->scheduler->ReadyToRun(thread);
+        }
+        else {
+            agingList_L3->Insert(thread);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::L1_Front_Remain
+// 	Return the remaining burst time of the first L1 thread, or -1 if
+//	L1 is empty.
+//----------------------------------------------------------------------
+
+int
+MultiLevelPolicy::L1_Front_Remain()
+{
+    if(levelMask & L1_Bit) return readyList_L1->Front()->get_Burst_Time() - readyList_L1->Front()->get_Use_Time();
+    else return -1;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Tick
+// 	Age the ready threads, then preempt "current" if it is in L3 and
+//	a thread is waiting in a higher level or its quantum is used up,
+//	if it is in L2 and an L1 thread is waiting, or if it is in L1 and
+//	the first L1 thread has a shorter remaining burst.
+//----------------------------------------------------------------------
+
+bool
+MultiLevelPolicy::Tick(Thread *current)
+{
+    // update priority
+    UpdatePriority();
+
+    int label = 0;
+
+    if(current->get_Priority() < 50){
+        if(levelMask & L1_Bit) label = 1;
+        if(levelMask & L2_Bit) label = 1;
+        if(kernel->stats->totalTicks - current->burst_Start_Time >= TimeQuantum) label = 1;
+    }
+
+    else if(current->get_Priority() >= 50 && current->get_Priority() < 100){
+        if(levelMask & L1_Bit) label = 1;
+    }
+
+    else {
+        int current_remain = current->get_Burst_Time() - current->get_Use_Time() - (kernel->stats->totalTicks - current->burst_Start_Time);
+        if((levelMask & L1_Bit) && current_remain > L1_Front_Remain()) label = 1;
+    }
+
+    return label == 1;
+}
+
+//----------------------------------------------------------------------
+// NewSchedulerPolicy
+// 	Return a new policy of the kind called "name" (as given with
+//	-sched on the command line), or the multi-level queue if there
+//	is no name.
+//----------------------------------------------------------------------
+
+SchedulerPolicy *
+NewSchedulerPolicy(char *name)
+{
+    if (name == NULL || strcmp(name, "mlfq") == 0)
+        return new MultiLevelPolicy();
+    if (strcmp(name, "fifo") == 0)
+        return new FifoPolicy(0);
+    if (strcmp(name, "rr") == 0)
+        return new FifoPolicy(TimeQuantum);
+    if (strcmp(name, "cfs") == 0)
+        return new FairSharePolicy();
+    if (strcmp(name, "lottery") == 0)
+        return new LotteryPolicy();
+    cerr << "Unknown scheduling policy " << name << "\n";
+    ASSERTNOTREACHED();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// FifoPolicy::FifoPolicy
+// 	Initialize an empty queue.
+//
+//	"quantum" -- ticks a thread may run before it is preempted, or
+//		0 to let it run until it gives up the CPU
+//----------------------------------------------------------------------
+
+FifoPolicy::FifoPolicy(int quantum)
+{
+    readyList = new List<Thread *>;
+    timeQuantum = quantum;
+}
+
+FifoPolicy::~FifoPolicy()
+{
+    delete readyList;
+}
+
+void
+FifoPolicy::Enqueue(Thread *thread)
+{
+    readyList->Append(thread);
+}
+
+Thread *
+FifoPolicy::Pick()
+{
+    if (readyList->IsEmpty())
+        return NULL;
+    return readyList->RemoveFront();
+}
+
+//----------------------------------------------------------------------
+// FifoPolicy::Tick
+// 	Preempt "current" once it has run for a quantum, if another
+//	thread is waiting.
+//----------------------------------------------------------------------
+
+bool
+FifoPolicy::Tick(Thread *current)
+{
+    return timeQuantum > 0 && !readyList->IsEmpty()
+           && kernel->stats->totalTicks - current->burst_Start_Time >= timeQuantum;
+}
+
+void
+FifoPolicy::Print()
+{
+    readyList->Apply(ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// cmp_Runtime
+// 	Order of the fair share queue: the least virtual run time first,
+//	then by ID.
+//----------------------------------------------------------------------
+
+static int
+cmp_Runtime(Thread *a, Thread *b)
+{
+    if (a->v_Runtime < b->v_Runtime) return -1;
+    else if (a->v_Runtime > b->v_Runtime) return 1;
+    else if (a->getID() > b->getID()) return 1;
+    else return -1;
+}
+
+//----------------------------------------------------------------------
+// FairSharePolicy::FairSharePolicy
+// 	Initialize an empty queue.
+//----------------------------------------------------------------------
+
+FairSharePolicy::FairSharePolicy()
+{
+    readyList = new ReadyHeap(cmp_Runtime);
+    minRuntime = 0;
+}
+
+FairSharePolicy::~FairSharePolicy()
+{
+    delete readyList;
+}
+
+//----------------------------------------------------------------------
+// FairSharePolicy::Runtime
+// 	Return the virtual run time of "thread" after "ticks" more of
+//	running.  A tick counts for 1 at priority 0, and for 1/16 at
+//	priority 149.
+//----------------------------------------------------------------------
+
+double
+FairSharePolicy::Runtime(Thread *thread, int ticks)
+{
+    return thread->v_Runtime + ticks * 10.0 / (thread->get_Priority() + 10);
+}
+
+//----------------------------------------------------------------------
+// FairSharePolicy::Charge
+// 	Add the time the running thread "thread" has used since it was
+//	last given the CPU.  Other threads have nothing to add.
+//----------------------------------------------------------------------
+
+void
+FairSharePolicy::Charge(Thread *thread)
+{
+    if (thread == kernel->currentThread)
+        thread->v_Runtime = Runtime(thread,
+                                    kernel->stats->totalTicks - thread->burst_Start_Time);
+}
+
+//----------------------------------------------------------------------
+// FairSharePolicy::Enqueue
+// 	Put a ready thread in the queue.  A new thread starts level with
+//	the threads already running, rather than ahead of all of them.
+//----------------------------------------------------------------------
+
+void
+FairSharePolicy::Enqueue(Thread *thread)
+{
+    if (thread->getStatus() == JUST_CREATED)
+        thread->v_Runtime = minRuntime;
+    Charge(thread);
+    readyList->Insert(thread);
+}
+
+Thread *
+FairSharePolicy::Pick()
+{
+    Thread *thread;
+
+    if (readyList->IsEmpty())
+        return NULL;
+    thread = readyList->RemoveFront();
+    if (thread->v_Runtime > minRuntime)
+        minRuntime = thread->v_Runtime;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// FairSharePolicy::Tick
+// 	Preempt "current" once it has run past the thread at the front
+//	of the queue.
+//----------------------------------------------------------------------
+
+bool
+FairSharePolicy::Tick(Thread *current)
+{
+    return !readyList->IsEmpty()
+           && Runtime(current, kernel->stats->totalTicks - current->burst_Start_Time)
+              > readyList->Front()->v_Runtime;
+}
+
+void
+FairSharePolicy::Block(Thread *thread)
+{
+    Charge(thread);
+}
+
+//----------------------------------------------------------------------
+// FairSharePolicy::Wakeup
+// 	A thread that slept for a long time comes back at most one quantum
+//	behind the others, so it can not take the CPU for as long as it
+//	slept.
+//----------------------------------------------------------------------
+
+void
+FairSharePolicy::Wakeup(Thread *thread)
+{
+    if (thread->v_Runtime < minRuntime - TimeQuantum)
+        thread->v_Runtime = minRuntime - TimeQuantum;
+}
+
+void
+FairSharePolicy::Print()
+{
+    for (int i = 0; i < readyList->NumInHeap(); i++)
+        ThreadPrint(readyList->Item(i));
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::LotteryPolicy
+// 	Initialize an empty queue.  The draws come from RandomNumber, so
+//	they repeat from run to run unless -rs gives another seed.
+//----------------------------------------------------------------------
+
+LotteryPolicy::LotteryPolicy()
+{
+    readyList = new List<Thread *>;
+    totalTickets = 0;
+}
+
+LotteryPolicy::~LotteryPolicy()
+{
+    delete readyList;
+}
+
+void
+LotteryPolicy::Enqueue(Thread *thread)
+{
+    readyList->Append(thread);
+    totalTickets += thread->get_Priority() + 1;
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::Pick
+// 	Draw a ticket, and take out the thread holding it.
+//----------------------------------------------------------------------
+
+Thread *
+LotteryPolicy::Pick()
+{
+    ListIterator<Thread *> iter(readyList);
+    Thread *thread = NULL;
+    int draw;
+
+    if (readyList->IsEmpty())
+        return NULL;
+    draw = RandomNumber() % totalTickets;
+    for (; !iter.IsDone(); iter.Next()) {
+        thread = iter.Item();
+        draw -= thread->get_Priority() + 1;
+        if (draw < 0)
+            break;
+    }
+    readyList->Remove(thread);
+    totalTickets -= thread->get_Priority() + 1;
+    return thread;
+}
+
+bool
+LotteryPolicy::Tick(Thread *current)
+{
+    return !readyList->IsEmpty()
+           && kernel->stats->totalTicks - current->burst_Start_Time >= TimeQuantum;
+}
+
+void
+LotteryPolicy::Print()
+{
+    readyList->Apply(ThreadPrint);
+}
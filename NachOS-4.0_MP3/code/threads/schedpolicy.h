@@ -0,0 +1,200 @@
+// schedpolicy.h
+//	Data structures for the scheduling policies: the order in which
+//	ready threads get the CPU, and when the running thread has to
+//	give it up.
+//
+//	The Scheduler hands every ready thread to its policy, asks the
+//	policy for the next thread to run, and asks it at every timer
+//	interrupt whether the running thread should be preempted.  The
+//	policy is chosen with "-sched" on the command line:
+//
+//	   fifo		first come, first served; never preempts
+//	   rr		round robin, one TimeQuantum per turn
+//	   mlfq		MP3 multi-level queue (the default): L1 by
+//			shortest remaining burst, L2 by priority, L3
+//			round robin, with aging between the levels
+//	   cfs		fair share: the least virtual run time first,
+//			where run time counts less at higher priority
+//	   lottery	each turn goes to a random thread, with a
+//			chance in proportion to its priority
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDPOLICY_H
+#define SCHEDPOLICY_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+
+#define TimeQuantum 100		// ticks a thread may run before
+				// round robin preempts it
+
+// MP3: L2 keeps one queue per priority, 50 to 99.
+#define L2_Lowest 50
+#define L2_Buckets 50
+
+// MP3: a binary heap of ready threads, the smallest first according
+// to "compare".  Each thread keeps its slot in the field "slot" points
+// to (heap_Index by default), so it can be taken out of the middle of
+// the heap as well, and can be in two heaps that use different fields.
+
+class ReadyHeap {
+  public:
+    ReadyHeap(int (*comp)(Thread *, Thread *),
+              int Thread::*slotField = &Thread::heap_Index);
+    ~ReadyHeap();
+
+    void Insert(Thread *thread);	// Put a thread in the heap
+    Thread *RemoveFront();		// Take out the smallest thread
+    void Remove(Thread *thread);	// Take out any thread in the heap
+
+    Thread *Front() { ASSERT(numItems > 0); return items[0]; }
+    bool IsEmpty() { return numItems == 0; }
+    int NumInHeap() { return numItems; }
+    Thread *Item(int i) { return items[i]; }
+    				// Threads in heap order, for walking
+				// the heap; 0 <= i < NumInHeap()
+
+  private:
+    int (*compare)(Thread *, Thread *);
+    int Thread::*slot;		// where a thread keeps its slot
+    Thread **items;		// items[0] is the smallest
+    int numItems;
+    int maxItems;		// size of items, grown on demand
+
+    void Place(int i, Thread *thread);
+    void SiftUp(int i);
+    void SiftDown(int i);
+};
+
+// The following class defines the interface of a scheduling policy.
+// All of it is called with interrupts disabled.
+
+class SchedulerPolicy {
+  public:
+    virtual ~SchedulerPolicy() {}
+
+    virtual void Enqueue(Thread *thread) = 0;
+    				// Put a ready thread in the queue: new,
+				// woken up, or giving up the CPU
+    virtual Thread *Pick() = 0;	// Take the next thread to run out of
+    				// the queue; NULL if there is none
+    virtual bool Tick(Thread *current) = 0;
+    				// Timer interrupt: return TRUE if
+				// "current" should give up the CPU
+    virtual void Block(Thread *thread) {}
+    				// The running thread goes to sleep,
+				// or finishes
+    virtual void Wakeup(Thread *thread) {}
+    				// A sleeping thread is about to be
+				// put in the queue again
+    virtual void Print() = 0;	// Print the threads in the queue
+};
+
+// Return the policy called "name" (as given with -sched), or the
+// multi-level queue if there is no name.
+extern SchedulerPolicy *NewSchedulerPolicy(char *name);
+
+// First come, first served, or round robin if "quantum" is not 0.
+
+class FifoPolicy : public SchedulerPolicy {
+  public:
+    FifoPolicy(int quantum);
+    ~FifoPolicy();
+
+    void Enqueue(Thread *thread);
+    Thread *Pick();
+    bool Tick(Thread *current);
+    void Print();
+
+  private:
+    List<Thread *> *readyList;
+    int timeQuantum;		// 0 for no preemption
+};
+
+// MP3: the multi-level queue.  L1 is a heap by remaining burst time;
+// L2 has a heap by thread ID for each priority, with a bitmask of the
+// priorities that have a thread; L3 is a heap by order of arrival, so
+// it is first in, first out.  Another bitmask says which levels have
+// a thread, so picking the next thread does not depend on how many
+// threads are ready.
+//
+// Aging is lazy: L1 and L3 threads are also kept in a heap by the time
+// they started waiting, and a timer interrupt only looks at the threads
+// at the front that have waited Aging_Interval ticks.
+
+class MultiLevelPolicy : public SchedulerPolicy {
+  public:
+    MultiLevelPolicy();
+    ~MultiLevelPolicy();
+
+    void Enqueue(Thread *thread);
+    Thread *Pick();
+    bool Tick(Thread *current);
+    void Print();
+
+  private:
+    enum { L1_Bit = 1, L2_Bit = 2, L3_Bit = 4 };
+
+    ReadyHeap *readyList_L1;
+    ReadyHeap *agingList_L1, *agingList_L3;  // by wait_Start_Time
+    ReadyHeap *readyList_L2[L2_Buckets];  // by priority - L2_Lowest
+    ReadyHeap *readyList_L3;	// by ready_Seq, so first in, first out
+    unsigned long long L2_Mask;	// bit i set if readyList_L2[i] has a thread
+    unsigned int levelMask;	// L1_Bit etc. set if the level has a thread
+    int readyCount;		// threads queued so far, for ready_Seq
+
+    void UpdatePriority();	// age the threads that waited long enough
+    int L1_Front_Remain();	// remaining burst of the first L1 thread
+    int L2_Bucket(Thread *thread);	// which readyList_L2 a thread goes in
+    void Insert_L2(Thread *thread);
+    void Remove_L2(Thread *thread, int bucket);
+};
+
+// Fair share: the thread with the least virtual run time runs first.
+// A thread's run time is charged to it divided by a weight that grows
+// with its priority, so higher priority threads get more of the CPU.
+
+class FairSharePolicy : public SchedulerPolicy {
+  public:
+    FairSharePolicy();
+    ~FairSharePolicy();
+
+    void Enqueue(Thread *thread);
+    Thread *Pick();
+    bool Tick(Thread *current);
+    void Block(Thread *thread);
+    void Wakeup(Thread *thread);
+    void Print();
+
+  private:
+    ReadyHeap *readyList;	// by v_Runtime
+    double minRuntime;		// v_Runtime of the last thread picked
+
+    void Charge(Thread *thread);	// add the CPU time it just used
+    double Runtime(Thread *thread, int ticks);
+    				// v_Runtime after running "ticks" more
+};
+
+// Lottery: each turn goes to a thread drawn at random, with a chance
+// in proportion to its tickets (its priority plus one).
+
+class LotteryPolicy : public SchedulerPolicy {
+  public:
+    LotteryPolicy();
+    ~LotteryPolicy();
+
+    void Enqueue(Thread *thread);
+    Thread *Pick();
+    bool Tick(Thread *current);
+    void Print();
+
+  private:
+    List<Thread *> *readyList;
+    int totalTickets;		// tickets of the threads in readyList
+};
+
+#endif // SCHEDPOLICY_H
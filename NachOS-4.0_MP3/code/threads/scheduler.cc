@@ -11,8 +11,8 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The order threads run in is up to the scheduling policy; see
+//	schedpolicy.cc.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -27,42 +27,25 @@
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads.
 //	Initially, no ready threads.
+//
+//	"policyName" -- the scheduling policy, as given with -sched,
+//		or NULL for the default
 //----------------------------------------------------------------------
 
-int cmp_BurstTime(Thread *a, Thread *b){
-    double at = a->get_Burst_Time() - a->get_Use_Time();
-    double bt = b->get_Burst_Time() - b->get_Use_Time();
-
-    if(at < 0) at = 0;
-    if(bt < 0) bt = 0;
-
-    if(at > bt) return 1;
-    else if(at < bt) return -1;
-    else if(a->getID() > b->getID()) return 1;
-    else return -1;
-}
-
-int cmp_Priority(Thread *a, Thread *b){
-    int ap = a->get_Priority();
-    int bp = b->get_Priority();
-
-    if(ap > bp) return -1;
-    else if(ap < bp) return 1;
-    else if(a->getID() > b->getID()) return 1;
-    else return -1;
-}
-
-Scheduler::Scheduler()
+Scheduler::Scheduler(char *policyName)
 { 
-    readyList_L1 = new SortedList<Thread *>(cmp_BurstTime); 
-    readyList_L2 = new SortedList<Thread *>(cmp_Priority);
-    readyList_L3 = new List<Thread *>;
-
+    policy = NewSchedulerPolicy(policyName);
+    name = (policyName == NULL) ? (char *)"mlfq" : policyName;
     toBeDestroyed = NULL;
-}
-
-
 
+    numSwitches = 0;
+    numFinished = 0;
+    totalTurnaround = 0;
+    totalResponse = 0;
+    accounts = new List<ThreadAccount *>;
+    kernel->currentThread->account->firstRunTick = 0;	// main, running
+    accounts->Append(kernel->currentThread->account);	// from the start
+}
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
@@ -71,9 +54,10 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete readyList_L1;
-    delete readyList_L2;
-    delete readyList_L3;
+    delete policy;
+    while (!accounts->IsEmpty())
+        delete accounts->RemoveFront();
+    delete accounts;
 } 
 
 //----------------------------------------------------------------------
@@ -89,25 +73,19 @@ void Scheduler::ReadyToRun (Thread *thread) {
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
 
-    thread->setStatus(READY);
-    
-    thread->wait_Start_Time = kernel->stats->totalTicks;
-
-    Thread *old_Thread = kernel->currentThread;
-    
-    if(thread->get_Priority() >= 100) {
-        DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[1]");
-        readyList_L1->Insert(thread);
-    }
-    else if(thread->get_Priority() >= 50) {
-        DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[2]");
-        readyList_L2->Insert(thread);
-    }
-    else {
-        DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into queue L[3]");
-        readyList_L3->Append(thread);
+    if (thread->getStatus() == BLOCKED)
+        policy->Wakeup(thread);
+    if (thread->getStatus() == JUST_CREATED) {
+        thread->account->createTick = kernel->stats->totalTicks;
+        thread->account->priority = thread->get_Priority();
+        accounts->Append(thread->account);
     }
 
+    thread->wait_Start_Time = kernel->stats->totalTicks;
+    thread->account->readySince = kernel->stats->totalTicks;
+
+    policy->Enqueue(thread);	// sees the old status
+    thread->setStatus(READY);
 }
 
 //----------------------------------------------------------------------
@@ -121,23 +99,54 @@ void Scheduler::ReadyToRun (Thread *thread) {
 Thread * Scheduler::FindNextToRun (){
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
-    if (readyList_L1->IsEmpty() == 0) {
-        Thread *thread = readyList_L1->Front();
-		DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from queue L[1]");
-        return readyList_L1->RemoveFront();   // ?
-    }
-    else if (readyList_L2->IsEmpty() == 0) {
-        Thread *thread = readyList_L2->Front();
-        DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from queue L[2]");
-		return readyList_L2->RemoveFront();
-    }
-    else if (readyList_L3->IsEmpty() == 0) {
-        Thread *thread = readyList_L3->Front();
-        DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from queue L[3]");
-		return readyList_L3->RemoveFront();
-    }
-    else {
-        return NULL;
+    return policy->Pick();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Tick
+// 	Called at every timer interrupt.  Return TRUE if the policy wants
+//	the current thread to give up the CPU.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Tick()
+{
+    return policy->Tick(kernel->currentThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Block
+// 	Tell the policy that "thread", the current thread, stops running
+//	to wait for something, or to finish.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Block(Thread *thread)
+{
+    policy->Block(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Finished
+// 	Record that "thread" has finished: when, and its turnaround and
+//	response time.  Called when it switches away for the last time,
+//	or by Thread::Finish just before the last program halts Nachos
+//	(with -ee), since there is no switch then.  Only the first call
+//	for a thread counts.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Finished(Thread *thread)
+{
+    ThreadAccount *a = thread->account;
+
+    if (a->finishTick >= 0)
+        return;
+    a->finishTick = kernel->stats->totalTicks;
+    if (a->createTick >= 0) {
+        numFinished++;
+        totalTurnaround += a->finishTick - a->createTick;
+        totalResponse += a->firstRunTick - a->createTick;
     }
 }
 
@@ -189,6 +198,16 @@ Scheduler::Run (Thread *nextThread, bool finishing)
                                  << "] is now selected for execution, thread [" << old_ID 
                                  << "] is replaced, and it has executed [" << old_Use_Time << "] ticks");
     
+    ThreadAccount *next = nextThread->account;
+
+    numSwitches++;
+    next->waitTicks[nextThread->get_Level() - 1] +=
+        kernel->stats->totalTicks - next->readySince;
+    if (next->firstRunTick < 0)
+        next->firstRunTick = kernel->stats->totalTicks;
+    if (finishing)
+        Finished(oldThread);
+
     kernel->currentThread = nextThread;  // switch to the next thread
     nextThread->setStatus(RUNNING);      // nextThread is now running
 
@@ -245,52 +264,123 @@ void
 Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyList_L3->Apply(ThreadPrint);
+    policy->Print();
 }
 
-// update priority and adjust the readyLists
+//----------------------------------------------------------------------
+// Scheduler::PrintStats
+// 	Print how well the policy did for the threads that finished:
+//	threads finished per 1000 ticks, the mean time from Fork to
+//	Finish (turnaround) and to the first time on the CPU (response),
+//	and the number of context switches.
+//----------------------------------------------------------------------
+
 void
-Scheduler::UpdatePriority()
+Scheduler::PrintStats()
 {
-    if(readyList_L1->IsEmpty() == 0){
-        ListIterator<Thread *> *iter1 = new ListIterator<Thread *>(readyList_L1);
-        for (; !iter1->IsDone(); iter1->Next()) {
-            iter1->Item()->aging(kernel->stats->totalTicks - iter1->Item()->wait_Start_Time);
-        }
-        delete iter1;
+    int ticks = kernel->stats->totalTicks;
+
+    cout << "Scheduler " << name << ": " << numFinished
+         << " threads finished in " << ticks << " ticks, "
+         << numSwitches << " context switches\n";
+    if (numFinished > 0) {
+        cout << "Throughput " << numFinished * 1000.0 / ticks
+             << " threads per 1000 ticks, mean turnaround "
+             << totalTurnaround / numFinished << " ticks, mean response "
+             << totalResponse / numFinished << " ticks\n";
     }
+}
 
-    if(readyList_L2->IsEmpty() == 0){
-        ListIterator<Thread *> *iter2 = new ListIterator<Thread *>(readyList_L2);
-        for (; !iter2->IsDone(); iter2->Next()) {
-            bool upgrade = iter2->Item()->aging(kernel->stats->totalTicks - iter2->Item()->wait_Start_Time);
-            if(upgrade) {
-                if(iter2->Item()->getID() > 0) {
-                    DEBUG(dbgScheduler, "[C] Tick [" << kernel->stats->totalTicks << "]: Thread [" << iter2->Item()->getID() << "] is removed from queue L[1]");
-                    readyList_L2->Remove(iter2->Item());
-                    kernel->scheduler->ReadyToRun(iter2->Item());
-                }
-            }
-            else {
-                readyList_L2->Remove(iter2->Item());
-                kernel->scheduler->ReadyToRun(iter2->Item());
-            }
-        }
-        delete iter2;
+//----------------------------------------------------------------------
+// PrintName
+// 	Print the name of a thread as a CSV field or a JSON string: in
+//	double quotes, with the quotes (and for JSON, backslashes) in it
+//	escaped.
+//----------------------------------------------------------------------
+
+static void
+PrintName(char *name, bool json)
+{
+    cout << '"';
+    for (char *c = name; *c != '\0'; c++) {
+        if (*c == '"')
+            cout << (json ? '\\' : '"');
+        else if (*c == '\\' && json)
+            cout << '\\';
+        cout << *c;
     }
+    cout << '"';
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintAccounts
+// 	Print a table of where the time of every thread forked so far
+//	went, one row per thread: ticks on the CPU in user and kernel
+//	code, ticks waiting in the ready queue, how often it was preempted
+//	and gave up the CPU on its own, and the ticks it ran and waited at
+//	each level of the multi-level queue.  For a thread that has not
+//	finished, ticks are up to now, but a wait in the ready queue is
+//	only counted once it is over, and "finish" is -1.  The program
+//	whose exit halts Nachos (with -ee) has finished: see Finished.
+//
+//	"format" -- "csv" for comma separated values with a header row,
+//		"json" for an array of objects
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintAccounts(char *format)
+{
+    static const char *fields[] = {
+        "id", "name", "priority", "create", "first_run", "finish",
+        "user_ticks", "system_ticks", "ready_ticks",
+        "preemptions", "voluntary",
+        "l1_run", "l2_run", "l3_run", "l1_wait", "l2_wait", "l3_wait"
+    };
+    const int numFields = sizeof(fields) / sizeof(fields[0]);
+    bool json = (strcmp(format, "json") == 0);
+    ListIterator<ThreadAccount *> it(accounts);
+    int values[numFields];
+    int i;
+
+    if (json)
+        cout << "[\n";
+    else {
+        for (i = 0; i < numFields; i++)
+            cout << fields[i] << (i < numFields - 1 ? "," : "\n");
+    }
+    for (; !it.IsDone(); it.Next()) {
+        ThreadAccount *a = it.Item();
+        int ready = a->waitTicks[0] + a->waitTicks[1] + a->waitTicks[2];
+
+        values[0] = a->id;
+        values[2] = a->priority;
+        values[3] = a->createTick;
+        values[4] = a->firstRunTick;
+        values[5] = a->finishTick;
+        values[6] = a->userTicks;
+        values[7] = a->systemTicks;
+        values[8] = ready;
+        values[9] = a->numPreemptions;
+        values[10] = a->numVoluntary;
+        for (i = 0; i < 3; i++) {
+            values[11 + i] = a->runTicks[i];
+            values[14 + i] = a->waitTicks[i];
+        }
 
-    if(readyList_L3->IsEmpty() == 0){
-        ListIterator<Thread *> *iter3 = new ListIterator<Thread *>(readyList_L3);
-        for (; !iter3->IsDone(); iter3->Next()) {
-            bool upgrade = iter3->Item()->aging(kernel->stats->totalTicks - iter3->Item()->wait_Start_Time);
-            if(upgrade) {
-                if(iter3->Item()->getID() > 0) {
-                    DEBUG(dbgScheduler, "[C] Tick [" << kernel->stats->totalTicks << "]: Thread [" << iter3->Item()->getID() << "] is removed from queue L[2]");
-                    readyList_L3->Remove(iter3->Item());
-                    kernel->scheduler->ReadyToRun(iter3->Item());
-                }
-            }
+        if (json)
+            cout << (a == accounts->Front() ? "  {" : ",\n  {");
+        for (i = 0; i < numFields; i++) {
+            if (json)
+                cout << (i > 0 ? ", " : "") << '"' << fields[i] << "\": ";
+            else if (i > 0)
+                cout << ",";
+            if (i == 1)
+                PrintName(a->name, json);
+            else
+                cout << values[i];
         }
-        delete iter3;
+        cout << (json ? "}" : "\n");
     }
+    if (json)
+        cout << "\n]\n";
 }
@@ -12,14 +12,19 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "schedpolicy.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+//
+// Which ready thread runs next, and when the running thread is
+// preempted, is left to a SchedulerPolicy (see schedpolicy.h).
 
 class Scheduler {
   public:
-    Scheduler();		// Initialize list of ready threads 
+    Scheduler(char *policyName);	// Initialize list of ready threads,
+    				// kept by the policy called policyName
     ~Scheduler();		// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	
@@ -34,32 +39,30 @@ class Scheduler {
     
     // SelfTest for scheduler is implemented in class Thread
 
-    void UpdatePriority(); // MP3: update thread priority
-    //void checkReadyList(); // MP3: adjust the belonging readyList of
-                           // the thread whose priority has been updated
-    bool L1_Empty() { 
-      return readyList_L1->IsEmpty(); 
-    }
-    
-    bool L2_Empty() { 
-      return readyList_L2->IsEmpty(); 
-    }
-
-    bool L3_Empty() { 
-      return readyList_L3->IsEmpty(); 
-    }
-
-    int L1_Front_Remain() {
-      if(readyList_L1->IsEmpty() == 0) return readyList_L1->Front()->get_Burst_Time() - readyList_L1->Front()->get_Use_Time();
-      else return -1;
-    }
+    bool Tick();		// Timer interrupt: should the current
+    				// thread give up the CPU?
+    void Block(Thread *thread);	// The current thread goes to sleep
+    void Finished(Thread *thread);	// Account for a finished thread
+    void PrintStats();		// Print throughput, turnaround and
+    				// response times so far
+    void PrintAccounts(char *format);
+    				// Print where the time of every thread
+				// went, as "csv" or "json"
 
   private:
-    SortedList<Thread *> *readyList_L1, *readyList_L2;
-    List<Thread *> *readyList_L3;  // MP3: queues of threads that are ready to run,
-				// but not running
+    SchedulerPolicy *policy;	// the ready threads, and the order
+    				// they run in
+    char *name;			// name of the policy
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
+
+    int numSwitches;		// context switches so far
+    int numFinished;		// threads finished so far
+    double totalTurnaround;	// from Fork to Finish, summed over
+    				// the finished threads
+    double totalResponse;	// from Fork to first run, likewise
+    List<ThreadAccount *> *accounts;
+    				// of every thread forked, in order
 };
 
 #endif // SCHEDULER_H
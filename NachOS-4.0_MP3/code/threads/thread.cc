@@ -45,6 +45,13 @@ Thread::Thread(char* threadName, int threadID)
     accumulate_Use_Time = 0;  
     wait_Time = 0;
     wait_Start_Time = 0;
+    heap_Index = -1;
+    aging_Index = -1;
+    ready_Seq = 0;
+    v_Runtime = 0;
+    account = new ThreadAccount(threadID, threadName);
+    preempted = FALSE;
+    wake_Tick = 0;
 
     stackTop = NULL;
     stack = NULL;
@@ -69,6 +76,13 @@ Thread::Thread(char* threadName, int threadID, int P)
     accumulate_Use_Time = 0;  
     wait_Time = 0;
     wait_Start_Time = 0;
+    heap_Index = -1;
+    aging_Index = -1;
+    ready_Seq = 0;
+    v_Runtime = 0;
+    account = new ThreadAccount(threadID, threadName);
+    preempted = FALSE;
+    wake_Tick = 0;
 
     stackTop = NULL;
     stack = NULL;
@@ -101,6 +115,8 @@ Thread::~Thread()
     ASSERT(this != kernel->currentThread);
     if (stack != NULL)
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    if (status == JUST_CREATED)		// never handed to the Scheduler,
+	delete account;			// which keeps it otherwise
 }
 
 //----------------------------------------------------------------------
@@ -210,15 +226,14 @@ Thread::Finish ()
     
     DEBUG(dbgThread, "Finishing thread: " << name);
 
-    // TODO
-    /*
-    if (kernel->execExit && this->getIsExec()) {
+    // with -ee, halt once every user program has finished
+    if (kernel->execExit && space != NULL) {
         kernel->execRunningNum--;
         if (kernel->execRunningNum == 0) {
+            kernel->scheduler->Finished(this);	// no switch away now
             kernel->interrupt->Halt();
         }
     }
-*/
 
 
     Sleep(TRUE);				// invokes SWITCH
@@ -261,8 +276,15 @@ Thread::Yield ()
 
     this->wait_Start_Time = kernel->stats->totalTicks;
 
+    bool forced = preempted;
+    preempted = FALSE;
+
     nextThread = kernel->scheduler->FindNextToRun();
     if (nextThread != NULL) {
+        if (forced)
+            account->numPreemptions++;
+        else
+            account->numVoluntary++;
         kernel->scheduler->ReadyToRun(this);
         kernel->scheduler->Run(nextThread, FALSE);
     }
@@ -300,6 +322,10 @@ Thread::Sleep (bool finishing)
     DEBUG(dbgThread, "Sleeping thread: " << name);
     DEBUG(dbgTraCode, "In Thread::Sleep, Sleeping thread: " << name << ", " << kernel->stats->totalTicks);
 
+    kernel->scheduler->Block(this);
+    if (!finishing)
+        account->numVoluntary++;
+
     // running -> waiting, update burst time
 
     double total_Use_Time = this->use_Time + (kernel->stats->totalTicks - this->burst_Start_Time);
@@ -550,13 +576,15 @@ void Thread::set_Accumulate_Use_Time(double T) {
 bool Thread::aging(int T) {
     this->set_Wait_Time(T);
     
-    if(this->wait_Time < 1500) return FALSE;
+    if(this->wait_Time < Aging_Interval) return FALSE;
     
     this->wait_Start_Time = kernel->stats->totalTicks;
 
     int old_Priority = this->priority;
     int new_Priority = old_Priority + 10;
     if(new_Priority > 149) new_Priority = 149;
+
+    int old_Level = this->get_Level();
     
     if(new_Priority != old_Priority) {
 
@@ -568,9 +596,60 @@ bool Thread::aging(int T) {
         this->set_Wait_Time(0);
         this->priority = new_Priority;
     }
+
+    if(this->get_Level() != old_Level) {    // the wait so far was at the old level
+        account->waitTicks[old_Level - 1] += kernel->stats->totalTicks - account->readySince;
+        account->readySince = kernel->stats->totalTicks;
+    }
     
     if((old_Priority < 100 && new_Priority >= 100) || (old_Priority < 50 && new_Priority >= 50)) {
         return TRUE;
     }
     return FALSE;
-}
\ No newline at end of file
+}
+
+int Thread::get_Level() {
+    if(priority >= 100) return 1;
+    if(priority >= 50) return 2;
+    return 3;
+}
+
+//----------------------------------------------------------------------
+// Thread::account_Ticks
+// 	Charge "T" ticks on the CPU to the thread, at the level it is at.
+//	Called by Interrupt::OneTick for the current thread, so the ticks
+//	of all the threads add up to the user and system ticks in Statistics.
+//
+//	"userMode" is set if the ticks were spent running user code.
+//----------------------------------------------------------------------
+
+void Thread::account_Ticks(int T, bool userMode) {
+    if(userMode) account->userTicks += T;
+    else account->systemTicks += T;
+    account->runTicks[this->get_Level() - 1] += T;
+}
+
+//----------------------------------------------------------------------
+// ThreadAccount::ThreadAccount
+// 	Start the account of a thread, with nothing charged yet.
+//----------------------------------------------------------------------
+
+ThreadAccount::ThreadAccount(int threadID, char *threadName)
+{
+    id = threadID;
+    strncpy(name, threadName, AccountNameLen);
+    name[AccountNameLen] = '\0';
+    priority = 0;
+    createTick = -1;
+    firstRunTick = -1;
+    finishTick = -1;
+    userTicks = 0;
+    systemTicks = 0;
+    for (int i = 0; i < 3; i++) {
+        runTicks[i] = 0;
+        waitTicks[i] = 0;
+    }
+    readySince = 0;
+    numPreemptions = 0;
+    numVoluntary = 0;
+}
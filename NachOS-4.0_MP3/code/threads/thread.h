@@ -62,6 +62,35 @@ const int StackSize = (8 * 1024);	// in words
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, ZOMBIE };
 
 
+// MP3: where the time of a thread went, for tuning the scheduler.  The
+// Scheduler keeps these once the thread is forked, so they are still
+// there after the thread is deleted (see Scheduler::PrintAccounts).
+// Levels are those of the multi-level queue: 1 for priority 100 and
+// up, 2 for 50 to 99, 3 below that.
+
+#define AccountNameLen 31
+
+class ThreadAccount {
+  public:
+    ThreadAccount(int threadID, char *threadName);
+
+    int id;
+    char name[AccountNameLen + 1];
+    int priority;		// when forked
+    int createTick;		// when forked, -1 for the main thread
+    int firstRunTick;		// when first given the CPU, -1 until then
+    int finishTick;		// when finished, -1 until then
+    int userTicks;		// on the CPU, running user code
+    int systemTicks;		// on the CPU, running kernel code
+    int runTicks[3];		// on the CPU, at each level
+    int waitTicks[3];		// in the ready queue, at each level
+    int readySince;		// when it last entered the ready queue,
+    				// or its level there changed
+    int numPreemptions;		// CPU taken away by the timer
+    int numVoluntary;		// CPU given up: Sleep, or Yield on its own
+};
+
+
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
 //
@@ -127,6 +156,10 @@ class Thread {
 
   bool aging(int T);
 
+  int get_Level();		// MP3 queue level of the priority
+  void account_Ticks(int T, bool userMode);
+  				// charge T ticks on the CPU
+
   private:
     // some of the private data for this class is listed above
     
@@ -160,6 +193,14 @@ class Thread {
     
     double burst_Start_Time;
     int wait_Start_Time;
+    int heap_Index;         // MP3: slot in a ready heap, -1 if in none
+    int aging_Index;        // MP3: slot in an aging heap, -1 if in none
+    int ready_Seq;          // MP3: order of arrival in the ready queue
+    double v_Runtime;       // virtual run time, for the fair share policy
+    ThreadAccount *account; // MP3: where its time went
+    bool preempted;         // MP3: is the next Yield forced by the timer?
+    int wake_Tick;          // MP3: when it is due to wake up, if it is
+                            // asleep in Alarm::WaitUntil
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
@@ -180,7 +221,11 @@ void SWITCH(Thread *oldThread, Thread *newThread);
 
 
 // TODO
+#define Aging_Interval 1500	// MP3: ticks of waiting per aging step
+
 extern int cmp_Priority(Thread *a, Thread *b);
 extern int cmp_BurstTime(Thread *a, Thread *b);
+extern int cmp_WaitStart(Thread *a, Thread *b);
+extern int cmp_ReadySeq(Thread *a, Thread *b);
 
 #endif // THREAD_H
@@ -90,6 +90,20 @@ void ExceptionHandler(ExceptionType which) {
                     ASSERTNOTREACHED();
                     break;
 
+                // sleep for the number of ticks in reg 4
+                case SC_Sleep:
+                    val = kernel->machine->ReadRegister(4);
+                    DEBUG(dbgSys, "Sleep " << val << " ticks\n");
+                    // renew the PrevPCReg、PCReg and NextPCReg before sleeping,
+                    // the same as sc_printint
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    SysSleep(val);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+
                 // call the msg to print the message store in the reg
                 case SC_MSG:
                     DEBUG(dbgSys, "Message received.\n");
@@ -28,6 +28,11 @@ void SysPrintInt(int val) {
     DEBUG(dbgTraCode, "In ksyscall.h:SysPrintInt, return from synchConsoleOut->PutInt, " << kernel->stats->totalTicks);
 }
 
+void SysSleep(int ticks) {
+    // leave the ready queue until the alarm wakes us up
+    kernel->alarm->WaitUntil(ticks);
+}
+
 int SysAdd(int op1, int op2) {
     return op1 + op2;
 }
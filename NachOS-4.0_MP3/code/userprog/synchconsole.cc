@@ -22,6 +22,7 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile) {
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    numWaiting = 0;
 }
 
 //----------------------------------------------------------------------
@@ -43,8 +44,10 @@ SynchConsoleInput::~SynchConsoleInput() {
 char SynchConsoleInput::GetChar() {
     char ch;
 
+    numWaiting++;
     lock->Acquire();
     waitFor->P();  // wait for EOF or a char to be available.
+    numWaiting--;
     ch = consoleInput->GetChar();
     lock->Release();
     return ch;
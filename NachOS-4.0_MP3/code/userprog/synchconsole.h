@@ -26,11 +26,14 @@ class SynchConsoleInput : public CallBackObj {
     ~SynchConsoleInput();                // Deallocate console device
 
     char GetChar();  // Read a character, waiting if necessary
+    bool IsWaiting() { return numWaiting > 0; }
+                     // Is a thread blocked in GetChar?
 
    private:
     ConsoleInput *consoleInput;  // the hardware keyboard
     Lock *lock;                  // only one reader at a time
     Semaphore *waitFor;          // wait for callBack
+    int numWaiting;              // threads inside GetChar
 
     void CallBack();  // called when a keystroke is available
 };
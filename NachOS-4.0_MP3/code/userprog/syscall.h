@@ -35,6 +35,7 @@
 #define SC_ThreadExit 14
 #define SC_ThreadJoin 15
 #define SC_PrintInt 16
+#define SC_Sleep 17
 #define SC_Add 42
 #define SC_MSG 100
 #ifndef IN_ASM
@@ -166,6 +167,11 @@ ThreadId ThreadFork(void (*func)());
  */
 void ThreadYield();
 
+/* Give up the CPU for at least "ticks" ticks of simulated time.  The
+ * thread is off the ready queue until then, so it takes no CPU time.
+ */
+void Sleep(int ticks);
+
 /*
  * Blocks current thread until lokal thread ThreadID exits with ThreadExit.
  * Function returns the ExitCode of ThreadExit() of the exiting thread.
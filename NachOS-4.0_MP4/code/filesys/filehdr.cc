@@ -42,6 +42,7 @@
 FileHeader::FileHeader()
 {
 	this->nextHeader = NULL; 
+	this->dirty = TRUE; // not on disk yet
 	this->nextSector = -1; 
 	numBytes = -1;
 	numSectors = -1;
@@ -70,49 +71,115 @@ FileHeader::~FileHeader()
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
-//	Allocate data blocks for the file out of the map of free disk blocks.
-//	Return FALSE if there are not enough free blocks to accomodate
-//	the new file.
+//	The file starts out sparse: only the headers needed to describe
+//	"fileSize" bytes are allocated, and every data block is a hole
+//	until something is written there (see AllocateSector).
+//	Return FALSE if there is no room left for the headers.
 //
 //	"freeMap" is the bit map of free disk sectors
 //	"fileSize" is the bit map of free disk sectors
+//	"nearSector" is the sector to allocate headers close to
 //----------------------------------------------------------------------
 
 // TODO begin
 
-bool FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
+bool FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize, int nearSector)
 {
+	numBytes = 0;
+	numSectors = 0;
+	dirty = TRUE;
+	return Extend(freeMap, fileSize, nearSector);
+}
 
-	int remain = fileSize;
-	if(fileSize > MaxFileSize) fileSize = MaxFileSize;
-	
-	remain = remain - MaxFileSize; 
-	numBytes = fileSize;
-	numSectors = divRoundUp(fileSize, SectorSize);    		// How many sector needed in a block
+// end
+
+//----------------------------------------------------------------------
+// FileHeader::Extend
+// 	Grow the file to "newLength" bytes.  The new blocks are holes;
+//	headers are added to the chain as needed, every header but the
+//	last describing MaxFileSize bytes.  Return FALSE if there is no
+//	room left for a header.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"newLength" is the new size of the file, in bytes
+//	"nearSector" is the sector to allocate headers close to
+//----------------------------------------------------------------------
 
-	if (freeMap->NumClear() < numSectors) return FALSE;  	// There are not enough free blocks to accomodate new file.
+bool FileHeader::Extend(PersistentBitmap *freeMap, int newLength, int nearSector)
+{
+	int length = min(newLength, (int)MaxFileSize);
+	int sectors = divRoundUp(length, SectorSize);
 
-	for (int i = 0; i < numSectors; i++){
-		dataSectors[i] = freeMap->FindAndSet();
-		ASSERT(dataSectors[i] >= 0);
+	if (length > numBytes)
+	{
+		for (int i = numSectors; i < sectors; i++)
+			dataSectors[i] = NoSector;
+		numBytes = length;
+		numSectors = sectors;
+		dirty = TRUE;
 	}
+	if (newLength <= (int)MaxFileSize)
+		return TRUE;
 
-	if(remain > 0){
-		if(this->nextHeader != NULL) return false;			// Already exist
+	if (nextHeader == NULL)
+	{
+		nextSector = freeMap->FindAndSetNear(nearSector);
+		dirty = TRUE;
+		if (nextSector == -1)
+			return FALSE;
+		nextHeader = new FileHeader;
+		nextHeader->numBytes = 0;
+		nextHeader->numSectors = 0;
+	}
+	return nextHeader->Extend(freeMap, newLength - MaxFileSize, nextSector);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::AllocateSector
+// 	Make sure there is a disk sector behind the byte at "offset",
+//	taking a free one close to "nearSector" if the block is a hole.
+//	Return the sector, or NoSector if the disk is full.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"offset" is the location within the file of the byte in question
+//	"nearSector" is the sector to allocate data close to
+//----------------------------------------------------------------------
 
-		nextSector = freeMap->FindAndSet();
-		if(nextSector == -1) return FALSE;
+int FileHeader::AllocateSector(PersistentBitmap *freeMap, int offset, int nearSector)
+{
+	int idx = divRoundDown(offset, SectorSize);
 
-		this->nextHeader = new FileHeader();
-		return nextHeader->Allocate(freeMap , remain);
+	if (idx >= (int)NumDirect)
+	{
+		ASSERT(nextHeader != NULL);
+		return nextHeader->AllocateSector(freeMap, offset - MaxFileSize, nearSector);
 	}
-
-	return TRUE;
+	ASSERT(idx < numSectors);
+	if (dataSectors[idx] == NoSector)
+	{
+		dataSectors[idx] = freeMap->FindAndSetNear(nearSector);
+		dirty = TRUE;
+	}
+	return dataSectors[idx];
 }
 
-// end
-
+//----------------------------------------------------------------------
+// FileHeader::AllocateAll
+// 	Fill in every hole of the file, keeping the blocks in order
+//	after "nearSector".  Used for the free map and directories, which
+//	are always written whole.  Return FALSE if the disk is full.
+//----------------------------------------------------------------------
 
+bool FileHeader::AllocateAll(PersistentBitmap *freeMap, int nearSector)
+{
+	for (int offset = 0; offset < FileLength(); offset += SectorSize)
+	{
+		nearSector = AllocateSector(freeMap, offset, nearSector);
+		if (nearSector == NoSector)
+			return FALSE;
+	}
+	return TRUE;
+}
 
 //----------------------------------------------------------------------
 // FileHeader::Deallocate
@@ -125,11 +192,17 @@ void FileHeader::Deallocate(PersistentBitmap *freeMap)
 {
 	for (int i = 0; i < numSectors; i++)
 	{
+		if (dataSectors[i] == NoSector)
+			continue; // a hole
 		ASSERT(freeMap->Test((int)dataSectors[i])); // ought to be marked!
 		freeMap->Clear((int)dataSectors[i]);
 	}
 	// TODO begin
-	if(nextHeader != NULL) nextHeader->Deallocate(freeMap);
+	if(nextHeader != NULL){
+		nextHeader->Deallocate(freeMap);
+		ASSERT(freeMap->Test(nextSector));
+		freeMap->Clear(nextSector);
+	}
 	// end
 }
 
@@ -175,7 +248,8 @@ void FileHeader::Deallocate(PersistentBitmap *freeMap)
 
 void FileHeader::FetchFrom(int sector)
 {
-	kernel->synchDisk->ReadSector(sector, (char *)this + sizeof(FileHeader*));
+	kernel->synchDisk->ReadSector(sector, (char *)&nextSector);
+	dirty = FALSE;
 	/*
 		MP4 Hint:
 		After you add some in-core informations, you will need to rebuild the header's structure
@@ -198,7 +272,9 @@ void FileHeader::FetchFrom(int sector)
 void FileHeader::WriteBack(int sector)
 {
 	// TODO begin
-	kernel->synchDisk->WriteSector(sector, (char *)this + sizeof(FileHeader*)); 
+	if (dirty)
+		kernel->synchDisk->WriteSector(sector, (char *)&nextSector);
+	dirty = FALSE;
 
 	if(this->nextHeader != NULL) nextHeader->WriteBack(nextSector);
 	
@@ -221,6 +297,8 @@ void FileHeader::WriteBack(int sector)
 //	offset in the file) to a physical address (the sector where the
 //	data at the offset is stored).
 //
+//	Return NoSector if the byte lies in a hole.
+//
 //	"offset" is the location within the file of the byte in question
 //----------------------------------------------------------------------
 // TODO begin
@@ -228,7 +306,8 @@ void FileHeader::WriteBack(int sector)
 int FileHeader::ByteToSector(int offset)
 {
 	int idx = divRoundDown(offset, SectorSize);
-	if(idx < NumDirect) return dataSectors[idx];
+	if(idx < NumDirect) return (idx < numSectors) ? dataSectors[idx] : NoSector;
+	else if(nextHeader == NULL) return NoSector;
 	else return nextHeader->ByteToSector(offset - MaxFileSize);
 }
 
@@ -275,7 +354,10 @@ void FileHeader::Print_File_Content()
 
 	for (i = k = 0; i < numSectors; i++)
 	{
-		kernel->synchDisk->ReadSector(dataSectors[i], data);
+		if (dataSectors[i] == NoSector)
+			memset(data, 0, SectorSize); // a hole reads as zeros
+		else
+			kernel->synchDisk->ReadSector(dataSectors[i], data);
 		for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++)
 		{
 			if ('\040' <= data[j] && data[j] <= '\176')
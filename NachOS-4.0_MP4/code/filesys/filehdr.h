@@ -20,6 +20,7 @@
 
 #define NumDirect ((SectorSize - 3 * sizeof(int)) / sizeof(int))
 #define MaxFileSize (NumDirect * SectorSize)
+#define NoSector -1 // data block not allocated yet (a hole)
 
 // The following class defines the Nachos "file header" (in UNIX terms,
 // the "i-node"), describing where on disk to find all of the data in the file.
@@ -32,6 +33,10 @@
 // as one disk sector.  Without indirect addressing, this
 // limits the maximum file length to just under 4K bytes.
 //
+// Files are sparse: a data block is only allocated when it is first
+// written, and until then reads as zeros.  A file can also grow past
+// the size given when it was created.
+//
 // There is no constructor; rather the file header can be initialized
 // by allocating blocks for the file (if it is a new file), or by
 // reading it from disk.
@@ -43,19 +48,31 @@ public:
 	FileHeader(); // dummy constructor to keep valgrind happy
 	~FileHeader();
 
-	bool Allocate(PersistentBitmap *bitMap, int fileSize); // Initialize a file header,
-														   //  including allocating space
-														   //  on disk for the file data
+	bool Allocate(PersistentBitmap *bitMap, int fileSize,
+				  int nearSector = 0);				   // Initialize a file header
+														   //  for a sparse file, with
+														   //  headers close to sector
+														   //  "nearSector"
+	bool Extend(PersistentBitmap *bitMap, int newLength,
+				int nearSector);					   // Grow the file, adding
+														   //  holes at the end
+	int AllocateSector(PersistentBitmap *bitMap, int offset,
+					   int nearSector);				   // Fill in the hole at
+														   //  "offset", if it is one
+	bool AllocateAll(PersistentBitmap *bitMap,
+					 int nearSector);				   // Fill in every hole
 	void Deallocate(PersistentBitmap *bitMap);			   // De-allocate this file's
 														   //  data blocks
 
 	void FetchFrom(int sectorNumber); // Initialize file header from disk
 	void WriteBack(int sectorNumber); // Write modifications to file header
-									  //  back to disk
+									  //  back to disk; headers of the
+									  //  chain left unchanged since they
+									  //  were read or written are skipped
 
 	int ByteToSector(int offset); // Convert a byte offset into the file
 								  // to the disk sector containing
-								  // the byte
+								  // the byte, NoSector for a hole
 
 	int FileLength(); // Return the length of the file
 					  // in bytes
@@ -87,13 +104,14 @@ private:
 		
 		Disk Part - numBytes, numSectors, dataSectors occupy exactly 128 bytes and will be
 		written to a sector on disk.
-		In-core part - none
+		In-core part - nextHeader, dirty
 		
 	*/
 	// TODO begin
 
 	FileHeader* nextHeader;
-	int nextSector; 
+	bool dirty;		// changed since last read or written?
+	int nextSector; // first field of the disk part
 
 	// end
 	int numBytes;				// Number of bytes in the file
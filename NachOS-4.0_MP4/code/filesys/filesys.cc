@@ -23,10 +23,15 @@
 //
 //	For those operations (such as Create, Remove) that modify the
 //	directory and/or bitmap, if the operation succeeds, the changes
-//	are written immediately back to disk (the two files are kept
-//	open during all this time).  If the operation fails, and we have
-//	modified part of the directory and/or bitmap, we simply discard
-//	the changed version, without writing it back to disk.
+//	are written back (the two files are kept open during all this
+//	time).  If the operation fails, and we have modified part of the
+//	directory and/or bitmap, we simply discard the changed version,
+//	without writing it back to disk.
+//
+//	The writes go through a metadata log (cf. journal.h): they are
+//	grouped into transactions, each committed to the log before any
+//	of it reaches its home location, and replayed at mount if Nachos
+//	stopped half way.
 //
 // 	Our implementation at this point has the following restrictions:
 //
@@ -35,9 +40,9 @@
 //	   files cannot be bigger than about 3KB in size
 //	   there is no hierarchical directory structure, and only a limited
 //	     number of files can be added to the system
-//	   there is no attempt to make the system robust to failures
-//	    (if Nachos exits in the middle of an operation that modifies
-//	    the file system, it may corrupt the disk)
+//	   only file system metadata is protected against failures
+//	    (if Nachos exits in the middle of writing a file, the file
+//	    may be left with part of the new data)
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -51,6 +56,10 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "journal.h"
+#include "fsck.h"
+#include "synchdisk.h"
+#include "main.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
@@ -65,6 +74,10 @@
 #define NumDirEntries 64 // TODO
 #define DirectoryFileSize (sizeof(DirectoryEntry) * NumDirEntries)
 
+// Bytes of a file grown or filled in by one transaction, so that a
+// large write stays well inside the log (cf. JournalMaxEntries).
+#define AllocateChunk (1024 * SectorSize)
+
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
 // 	Initialize the file system.  If format = TRUE, the disk has
@@ -73,7 +86,8 @@
 //	not all of the sectors marked as free).
 //
 //	If format = FALSE, we just have to open the files
-//	representing the bitmap and the directory.
+//	representing the bitmap and the directory, after replaying any
+//	metadata transaction left committed in the log.
 //
 //	"format" -- should we initialize the disk?
 //----------------------------------------------------------------------
@@ -81,9 +95,11 @@
 FileSystem::FileSystem(bool format)
 {
     DEBUG(dbgFile, "Initializing the file system.");
+    journal = new Journal;
+    kernel->synchDisk->SetJournal(journal);
     if (format)
     {
-        PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
+        freeMap = new PersistentBitmap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
         FileHeader *mapHdr = new FileHeader;
         FileHeader *dirHdr = new FileHeader;
@@ -94,12 +110,17 @@ FileSystem::FileSystem(bool format)
         // (make sure no one else grabs these!)
         freeMap->Mark(FreeMapSector);
         freeMap->Mark(DirectorySector);
+        journal->Format(freeMap);
 
         // Second, allocate space for the data blocks containing the contents
         // of the directory and bitmap files.  There better be enough space!
 
+        // Both files are always written whole, so they get all of their
+        // blocks now rather than as they are written.
         ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize));
+        ASSERT(mapHdr->AllocateAll(freeMap, FreeMapSector));
         ASSERT(dirHdr->Allocate(freeMap, DirectoryFileSize));
+        ASSERT(dirHdr->AllocateAll(freeMap, DirectorySector));
 
         // Flush the bitmap and directory FileHeaders back to disk
         // We need to do this before we can "Open" the file, since open
@@ -132,7 +153,6 @@ FileSystem::FileSystem(bool format)
             freeMap->Print();
             directory->Print();
         }
-        delete freeMap;
         delete directory;
         delete mapHdr;
         delete dirHdr;
@@ -141,11 +161,12 @@ FileSystem::FileSystem(bool format)
     {
         // if we are not formatting the disk, just open the files representing
         // the bitmap and directory; these are left open while Nachos is running
+        journal->Recover();
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
+        freeMap = new PersistentBitmap(freeMapFile, NumSectors);
     }
-    // TODO
-    fileDescriptor = NULL;
+    openFileTable = new OpenFileTable;
 }
 
 //----------------------------------------------------------------------
@@ -154,8 +175,147 @@ FileSystem::FileSystem(bool format)
 //----------------------------------------------------------------------
 FileSystem::~FileSystem()
 {
+    delete freeMap;
     delete freeMapFile;
     delete directoryFile;
+    delete openFileTable;
+    delete journal;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Sync
+// 	Commit the metadata changes still waiting in the log.  Must be
+//	called before Nachos halts, or they are lost.
+//----------------------------------------------------------------------
+
+void FileSystem::Sync()
+{
+    journal->Sync();
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Check
+// 	Check the file system on disk (see fsck.h), print what is wrong,
+//	and return the number of problems found.
+//
+//	Every sector reachable from the root directory or the free map
+//	file, and the journal area, must be marked in the free map, and
+//	nothing else may be.  A sector reachable twice belongs to two
+//	files (or a directory is linked into the tree twice); that is
+//	reported, but not repaired.
+//
+//	"repair" -- if TRUE, mark and clear sectors in the free map so
+//		that it agrees with what is reachable, and write it back
+//----------------------------------------------------------------------
+
+int FileSystem::Check(bool repair)
+{
+    FileSystemCheck *check = new FileSystemCheck;
+    int problems, fixed = 0;
+
+    Sync(); // check what is on disk, with nothing left in the log
+    if (journal->IsEnabled())
+        check->Reserve(JournalStart, JournalSectors);
+    problems = check->Run(FreeMapSector, DirectorySector);
+    check->PrintReport();
+
+    for (int i = 0; i < NumSectors; i++)
+    {
+        if (check->RefCount(i) > 1)
+        {
+            printf("sector %d is used %d times\n", i, check->RefCount(i));
+            problems++;
+        }
+        if (check->RefCount(i) > 0 && !freeMap->Test(i))
+        {
+            printf("sector %d is in use but marked free\n", i);
+            problems++;
+            if (repair)
+            {
+                freeMap->Mark(i);
+                fixed++;
+            }
+        }
+        else if (check->RefCount(i) == 0 && freeMap->Test(i))
+        {
+            printf("sector %d is marked in use but unreachable\n", i);
+            problems++;
+            if (repair)
+            {
+                freeMap->Clear(i);
+                fixed++;
+            }
+        }
+    }
+
+    if (fixed > 0)
+    {
+        journal->Begin();
+        freeMap->WriteBack(freeMapFile);
+        journal->End();
+        Sync();
+        printf("Fixed %d sectors in the free map.\n", fixed);
+    }
+    printf("%d problems found.\n", problems);
+    delete check;
+    return problems;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::AllocateBlocks
+// 	Called by OpenFile before writing bytes "from" up to "to" - 1 of
+//	a file.  Grow the file if "to" is past its end, and fill in the
+//	holes in the range with blocks close to the ones before them.
+//	The header and the free map are written back in transactions of
+//	their own, one for every AllocateChunk bytes, so that however
+//	large the range, each fits in the log.
+//
+//	Return FALSE if the disk filled up; whatever was allocated up to
+//	that point stays with the file.
+//
+//	"hdrSector" -- the sector holding the file header
+//	"hdr" -- the file header, as kept by the open file
+//	"from", "to" -- the range of bytes about to be written
+//----------------------------------------------------------------------
+
+bool FileSystem::AllocateBlocks(int hdrSector, FileHeader *hdr, int from, int to)
+{
+    int offset = divRoundDown(from, SectorSize) * SectorSize;
+    int nearSector = hdrSector;
+    int length, sector, end;
+    bool success = TRUE;
+
+    // grow the file first, a chunk at a time
+    while (success && (length = hdr->FileLength()) < to)
+    {
+        journal->Begin();
+        success = hdr->Extend(freeMap, min(to, length + AllocateChunk),
+                              hdrSector);
+        hdr->WriteBack(hdrSector);
+        freeMap->WriteBack(freeMapFile);
+        journal->End();
+    }
+
+    if (offset > 0 && hdr->ByteToSector(offset - SectorSize) != NoSector)
+        nearSector = hdr->ByteToSector(offset - SectorSize);
+    while (success && offset < to)
+    {
+        end = min(to, offset + AllocateChunk);
+        journal->Begin();
+        for (; success && offset < end; offset += SectorSize)
+        {
+            sector = hdr->ByteToSector(offset);
+            if (sector == NoSector)
+                sector = hdr->AllocateSector(freeMap, offset, nearSector);
+            if (sector == NoSector)
+                success = FALSE;
+            nearSector = sector;
+        }
+        hdr->WriteBack(hdrSector);
+        freeMap->WriteBack(freeMapFile);
+        journal->End();
+    }
+    return success;
 }
 
 //----------------------------------------------------------------------
@@ -197,12 +357,12 @@ int FileSystem::return_sector(char* parent_path){
     while(temp){
         sector = directory->Find(temp); 
         if(sector == -1){
+            delete directory;
             return -1;
         }
-        openFile = new OpenFile(sector);
+        openFile = openFileTable->Open(sector);
         directory->FetchFrom(openFile);
         delete openFile;
-        //delete openFile;
         temp = strtok(NULL , "/");
     }
     delete directory;
@@ -214,11 +374,12 @@ int FileSystem::return_sector(char* parent_path){
 
 bool FileSystem::CreateDirectory(char* name){
     Directory *directory = new Directory(NumDirEntries);
-    PersistentBitmap *freeMap;
+    OpenFile *parentFile = NULL;  // the parent directory, unless root
     FileHeader *hdr;
     int sector;
     bool success = true;
     DEBUG(dbgFile, "Creating a directory " << name);
+    journal->Begin();
     //---
     char* parent_path = new char[500];
     char* target_name = new char[500];
@@ -230,12 +391,13 @@ bool FileSystem::CreateDirectory(char* name){
     directory->FetchFrom(directoryFile);
 
     if(temp != NULL){
-        if(OpenDir(parent_path) == NULL){
+        parentFile = OpenDir(parent_path);
+        if(parentFile == NULL){
             success = false;
         }
         else{
             DEBUG(dbgFile, "[FileSystem::CreateDirectory] with " << parent_path);
-            directory->FetchFrom(OpenDir(parent_path));
+            directory->FetchFrom(parentFile);
         }
     }
     else{
@@ -246,14 +408,14 @@ bool FileSystem::CreateDirectory(char* name){
         success = FALSE; 
     }
     if(success){
-        freeMap = new PersistentBitmap(freeMapFile,NumSectors);
         sector = freeMap->FindAndSet();
         bool isAdd = directory->Add(target_name, sector, true);
         if (sector == -1 || !isAdd) 
             success = FALSE;
         else {
             hdr = new FileHeader;
-            if (!hdr->Allocate(freeMap, DirectoryFileSize))
+            if (!hdr->Allocate(freeMap, DirectoryFileSize, sector) ||
+                !hdr->AllocateAll(freeMap, sector))
                 success = FALSE;	
             else {
                 success = TRUE; 
@@ -261,28 +423,30 @@ bool FileSystem::CreateDirectory(char* name){
                 if(!temp){
                     // root
                     directory->WriteBack(directoryFile);
-                    Directory * new_dir = new Directory(NumDirEntries);
-                    OpenFile* f = new OpenFile(sector); 
-                    new_dir->WriteBack(f); 
                     DEBUG(dbgFile, "[FileSystem::CreateDirectory] Root and create Entry in sector " << sector);
                 }
                 else{
                     DEBUG(dbgFile, "[FileSystem::CreateDirectory] Not Root and write to sector " << sector);
-                    directory->WriteBack(OpenDir(parent_path));
-                    Directory * new_dir = new Directory(NumDirEntries);
-                    OpenFile* f = new OpenFile(sector); 
-                    new_dir->WriteBack(f); 
+                    directory->WriteBack(parentFile);
                 }
+                Directory * new_dir = new Directory(NumDirEntries);
+                OpenFile* f = openFileTable->Open(sector);
+                new_dir->WriteBack(f);
+                delete f;
+                delete new_dir;
                 freeMap->WriteBack(freeMapFile);
             }
             delete hdr;
         }
     }
+    if (!success)
+        freeMap->FetchFrom(freeMapFile); // undo any allocation
+    delete parentFile;
     delete parent_path;
     delete temp_path;
     delete target_name;
-    delete freeMap;
     delete directory;
+    journal->End();
     return success;
 }
 
@@ -292,11 +456,12 @@ bool FileSystem::CreateDirectory(char* name){
 bool FileSystem::Create(char *name, int initialSize)
 {
     Directory *directory;
-    PersistentBitmap *freeMap;
+    OpenFile *parentFile = NULL;  // the parent directory, unless root
     FileHeader *hdr;
     int sector;
     bool success = TRUE;
     DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
+    journal->Begin();
     directory = new Directory(NumDirEntries);
 
     //---
@@ -312,12 +477,13 @@ bool FileSystem::Create(char *name, int initialSize)
     
     if(temp != NULL){
         DEBUG(dbgFile, "[FileSystem::Create] Not root and path " << parent_path);
-        if(OpenDir(parent_path) == NULL){
+        parentFile = OpenDir(parent_path);
+        if(parentFile == NULL){
             DEBUG(dbgFile, "[FileSystem::Create] path doesn't exists");
             success = FALSE;
         }
         else{
-            directory->FetchFrom(OpenDir(parent_path));
+            directory->FetchFrom(parentFile);
         }
     }
     else{
@@ -328,7 +494,6 @@ bool FileSystem::Create(char *name, int initialSize)
     }
     if(success == TRUE){
         DEBUG(dbgFile, "[FileSystem::Create] No name conflict ");
-        freeMap = new PersistentBitmap(freeMapFile, NumSectors);
         sector = freeMap->FindAndSet(); 
         if (sector == -1)
             success = FALSE; 
@@ -337,7 +502,7 @@ bool FileSystem::Create(char *name, int initialSize)
         else{
             DEBUG(dbgFile, "[FileSystem::Create] enough sector & successfully add ");
             hdr = new FileHeader;
-            if (!hdr->Allocate(freeMap, initialSize))
+            if (!hdr->Allocate(freeMap, initialSize, sector))
                 success = FALSE; 
             else{
                 success = TRUE;
@@ -345,7 +510,7 @@ bool FileSystem::Create(char *name, int initialSize)
                 DEBUG(dbgFile, "[FileSystem::Create] write back to sector " << sector);
                 hdr->WriteBack(sector);
     
-                if(temp != NULL) directory->WriteBack(OpenDir(parent_path));
+                if(temp != NULL) directory->WriteBack(parentFile);
                 else directory->WriteBack(directoryFile);
                 
                 freeMap->WriteBack(freeMapFile);
@@ -353,11 +518,14 @@ bool FileSystem::Create(char *name, int initialSize)
         delete hdr;
         }
     }
+    if (!success)
+        freeMap->FetchFrom(freeMapFile); // undo any allocation
+    delete parentFile;
     delete parent_path;
     delete temp_path;
     delete target_name;
-    delete freeMap;
     delete directory;
+    journal->End();
     return success;
 }
 // end
@@ -385,7 +553,7 @@ void FileSystem::SplitPath(char* fullpath, char* parent_dir, char* target_name)
 OpenFile* FileSystem::OpenDir(char* parent_path){
     Directory *directory = new Directory(NumDirEntries);
     OpenFile* openFile = NULL;
-    int sector;
+    int sector = DirectorySector;
     char* new_path = new char[500];
     strcpy(new_path, parent_path);
     directory->FetchFrom(directoryFile);
@@ -394,15 +562,19 @@ OpenFile* FileSystem::OpenDir(char* parent_path){
     while(temp){
         sector = directory->Find(temp); 
         DEBUG(dbgFile, "[FileSystem::OpenDir] temp  " << temp << " sector " << sector);
-        if(sector == -1) return NULL;
-        openFile = new OpenFile(sector);
+        if(sector == -1){
+            delete directory;
+            delete new_path;
+            return NULL;
+        }
+        openFile = openFileTable->Open(sector);
         directory->FetchFrom(openFile);
         delete openFile;
         temp = strtok(NULL , "/");
     }
     delete directory;
     delete new_path;
-    openFile = new OpenFile(sector);
+    openFile = openFileTable->Open(sector);
     return openFile;
 }
 
@@ -440,20 +612,21 @@ OpenFile * FileSystem::Open(char *name)
         sector = directory->Find(target_name); 
         DEBUG(dbgFile, "[FileSystem::Open] Find " << target_name << " in " << sector);
 
-        if (sector >= 0) openFile = new OpenFile(sector);
+        if (sector >= 0) openFile = openFileTable->Open(sector);
         else openFile = NULL;
         
     }else{
-        if(OpenDir(parent_path) != NULL){
-            directory->FetchFrom(OpenDir(parent_path));
+        OpenFile* dirFile = OpenDir(parent_path);
+        if(dirFile != NULL){
+            directory->FetchFrom(dirFile);
+            delete dirFile;
             sector = directory->Find(target_name);
-            openFile = new OpenFile(sector);
+            if (sector >= 0) openFile = openFileTable->Open(sector);
         }
         else{
             openFile = NULL;
         }
     }
-    this->fileDescriptor = openFile;
     
     delete directory;
     delete parent_path;
@@ -463,46 +636,6 @@ OpenFile * FileSystem::Open(char *name)
 }
 // end
 
-int FileSystem::OpenAFile(char* filename){
-    OpenFile* openfile = this->Open(filename);
-    DEBUG(dbgSys, "Opening A file" << filename);
-    if(openfile == NULL){
-        return 0;
-    }
-    return 1;
-}
-
-int FileSystem::Read(char *buffer, int size, int id){
-    DEBUG(dbgFile, "FileSystem::Read with file size = " << size);
-    if(id < 0 || size < 0) return -1;
-    else{
-        if(!this->fileDescriptor){
-            return -1;
-        }
-        else{
-            return fileDescriptor->Read(buffer, size);
-        }
-    }
-}
-
-int FileSystem::Write(char *buffer, int size, int id){
-    if(id < 0 && size < 0) return -1;
-    else{
-        if(!this->fileDescriptor){
-            DEBUG(dbgFile, "File Not Found " << size);
-            return -1;
-        }
-        return fileDescriptor->Write(buffer, size);
-    }
-}
-
-int FileSystem::Close(int id){
-    /* Close the file by id . Here, this operation will always succeed and return 1. */
-    delete fileDescriptor;
-    fileDescriptor = NULL;
-    return 1;
-}
-
 //----------------------------------------------------------------------
 // FileSystem::Remove
 // 	Delete a file from the file system.  This requires:
@@ -522,14 +655,15 @@ int FileSystem::Close(int id){
 bool FileSystem::Remove(char *name)
 {
     Directory *directory;
-    PersistentBitmap *freeMap;
-    FileHeader *fileHdr;
+    OpenFile *parentFile = NULL;  // the parent directory, unless root
+    FileHeader *fileHdr = NULL;
     int sector;
     directory = new Directory(NumDirEntries);
     bool success = true;
     char* parent_path = new char[500];
     char* target_name = new char[500];
 
+    journal->Begin();
     directory->FetchFrom(directoryFile);
 
     char* temp_path = new char[500];
@@ -538,11 +672,12 @@ bool FileSystem::Remove(char *name)
     char* temp = strtok(temp_path , "/");
 
     if(temp != NULL){
-        if(OpenDir(parent_path) == NULL){
+        parentFile = OpenDir(parent_path);
+        if(parentFile == NULL){
             success = false;
         }
         else{
-            directory->FetchFrom(OpenDir(parent_path));
+            directory->FetchFrom(parentFile);
         }
     }
     if (directory->Find(target_name) == -1){
@@ -552,21 +687,23 @@ bool FileSystem::Remove(char *name)
         sector = directory->Find(target_name);
         fileHdr = new FileHeader;
         fileHdr->FetchFrom(sector);
-        freeMap = new PersistentBitmap(freeMapFile, NumSectors);
 
         fileHdr->Deallocate(freeMap); 
         freeMap->Clear(sector);       
         directory->Remove(target_name);
         freeMap->WriteBack(freeMapFile);     
-        directory->WriteBack(OpenDir(parent_path)); 
+        directory->WriteBack(parentFile != NULL ? parentFile : directoryFile);
     }
     
+    delete parentFile;
     delete parent_path;
     delete target_name;
     delete temp_path;
     delete fileHdr;
     delete directory;
-    delete freeMap;
+    journal->End();
+    journal->Sync(); // freed sectors must not be reused before
+                     // the free is on disk
     return TRUE;
 }
 
@@ -652,7 +789,13 @@ void FileSystem::List(char* name , bool recursive)
     char* temp = strtok(temp_path , "/");
 
     //non-root
-    if(temp) directory->FetchFrom(OpenDir(parent_path));
+    if(temp){
+        OpenFile* dirFile = OpenDir(parent_path);
+        if(dirFile != NULL){
+            directory->FetchFrom(dirFile);
+            delete dirFile;
+        }
+    }
     
     directory->List();
     
@@ -676,7 +819,11 @@ void FileSystem::recursiveList(char* name , int layer){
     strcpy(temp_path, parent_path);
     char* temp = strtok(temp_path , "/");
     if(temp){
-        directory->FetchFrom(OpenDir(parent_path));
+        OpenFile* dirFile = OpenDir(parent_path);
+        if(dirFile != NULL){
+            directory->FetchFrom(dirFile);
+            delete dirFile;
+        }
     }
     DirectoryEntry* table = directory->GetTable();
     for(int i = 0 ; i < NumDirEntries ; i++){
@@ -726,7 +873,6 @@ void FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile, NumSectors);
     Directory *directory = new Directory(NumDirEntries);
 
     printf("Bit map file header:\n");
@@ -744,7 +890,6 @@ void FileSystem::Print()
 
     delete bitHdr;
     delete dirHdr;
-    delete freeMap;
     delete directory;
 }
 
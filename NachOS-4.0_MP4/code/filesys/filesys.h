@@ -39,6 +39,10 @@
 
 typedef int OpenFileId;
 
+class Journal;
+class FileHeader;
+class PersistentBitmap;
+
 #ifdef FILESYS_STUB // Temporarily implement file system calls as
 // calls to UNIX, until the real file system
 // implementation is available
@@ -88,6 +92,16 @@ public:
 	// MP4 mod tag
 	~FileSystem();
 
+	void Sync(); // Commit metadata changes waiting
+				 // in the log
+
+	int Check(bool repair); // Check the disk for consistency,
+							// fixing the free map if "repair"
+
+	bool AllocateBlocks(int hdrSector, FileHeader *hdr, int from, int to);
+	// Back a range of a file with disk
+	// blocks, growing it if needed
+
 	bool Create(char *name, int initialSize);
 	// Create a file (UNIX creat)
 
@@ -106,14 +120,6 @@ public:
 	void recursiveList(char* name , int layer);
 	void Print(); // List all the files and their contents
 	// TODO begin
-	int OpenAFile(char* name);
-
-	int Read(char* buffer,int  size, int id);
-	
-    int Write(char* buffer, int size, int id);
-
-    int Close(int id);
-
 	OpenFile* OpenDir(char* parent_path);
 
 	void SplitPath(char* fullpath, char* parent_dir, char* target_name); 
@@ -126,8 +132,11 @@ private:
 							 // represented as a file
 	OpenFile *directoryFile; // "Root" directory -- list of
 							 // file names, represented as a file
-	// TODO
-	OpenFile* fileDescriptor;
+	OpenFileTable *openFileTable; // System-wide table of open files,
+								  // one shared header per file
+	Journal *journal;		 // Write-ahead log of metadata changes
+	PersistentBitmap *freeMap; // Free sectors, kept in memory and
+							   // written back as it changes
 };
 
 #endif // FILESYS
@@ -0,0 +1,385 @@
+// fsck.cc
+//	Routines to check the file system on disk for consistency.  See
+//	fsck.h for how the check works.
+//
+//	Everything here reads the copy of the disk in memory, without
+//	going through FileHeader or Directory: those read the disk with
+//	SynchDisk, which only a Nachos thread may do, while the walk runs
+//	in host threads.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "fsck.h"
+#include "filehdr.h"
+#include "directory.h"
+#include "synchdisk.h"
+#include "main.h"
+
+// A file header as stored on disk: FileHeader without its in-core
+// pointer to the next header (see FileHeader::WriteBack).
+
+class DiskFileHeader
+{
+public:
+    int nextSector;             // next header in the chain, or -1
+    int numBytes;               // bytes described by this header
+    int numSectors;             // data sectors in this header
+    int dataSectors[NumDirect]; // data sectors, NoSector for a hole
+};
+
+// A directory just below the root, to be walked by a worker, with
+// what the walk found.
+
+class FsckSubtree
+{
+public:
+    int sector;             // header of the directory
+    char path[FsckPathLen]; // full name of the directory
+    List<char *> *out;      // problems found below it
+    int problems;           // how many
+};
+
+//----------------------------------------------------------------------
+// Problem
+// 	Add a line about a problem in "path" to a report.
+//----------------------------------------------------------------------
+
+static void
+Problem(List<char *> *out, const char *path, const char *what, int value)
+{
+    int len = strlen(path) + 80;
+    char *line = new char[len];
+
+    snprintf(line, len, "%s: %s %d\n", path, what, value);
+    out->Append(line);
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::FileSystemCheck
+// 	Set up a check with no sector in use yet.
+//----------------------------------------------------------------------
+
+FileSystemCheck::FileSystemCheck()
+{
+    ASSERT(sizeof(DiskFileHeader) == SectorSize);
+    image = NULL;
+    report = new List<char *>;
+    refs = new int[NumSectors];
+    bzero((char *)refs, NumSectors * sizeof(int));
+    subtrees = NULL;
+    numSubtrees = 0;
+    nextSubtree = 0;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::~FileSystemCheck
+// 	De-allocate the copy of the disk and the counts.
+//----------------------------------------------------------------------
+
+FileSystemCheck::~FileSystemCheck()
+{
+    delete[] image;
+    delete[] refs;
+    delete[] subtrees;
+    while (!report->IsEmpty())
+        delete[] report->RemoveFront();
+    delete report;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::PrintReport
+// 	Print the problems found by Run, one per line.
+//----------------------------------------------------------------------
+
+void FileSystemCheck::PrintReport()
+{
+    ListIterator<char *> iter(report);
+
+    for (; !iter.IsDone(); iter.Next())
+        printf("%s", iter.Item());
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::Reserve
+// 	Count "count" sectors starting at "first" as in use, although no
+//	file claims them.
+//----------------------------------------------------------------------
+
+void FileSystemCheck::Reserve(int first, int count)
+{
+    for (int i = first; i < first + count; i++)
+        refs[i]++;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::Run
+// 	Read the disk, then walk the free map file and the directory tree
+//	from the root.  The root is checked here; each directory in it is
+//	handed to the worker threads, and the reports are put together in
+//	directory order once they are all done.
+//
+//	Return the number of problems found in headers and directories.
+//	Sectors used twice, or not marked in the free map, are left for
+//	the caller to find from RefCount.
+//
+//	"mapSector" -- the header of the free map file
+//	"rootSector" -- the header of the root directory
+//----------------------------------------------------------------------
+
+int FileSystemCheck::Run(int mapSector, int rootSector)
+{
+    char *contents = NULL;
+    int size = 0;
+    DirectoryEntry *table;
+    void *workers[FsckWorkers];
+    int problems, numEntries, i;
+
+    ReadImage();
+    problems = CheckHeader(mapSector, "(free map)", NULL, NULL, report);
+    problems += CheckHeader(rootSector, "/", &contents, &size, report);
+
+    table = (DirectoryEntry *)contents;
+    numEntries = size / sizeof(DirectoryEntry);
+    subtrees = new FsckSubtree[numEntries];
+    for (i = 0; i < numEntries; i++)
+    {
+        if (!table[i].inUse)
+            continue;
+        if (table[i].name[FileNameMaxLen] != '\0')
+        {
+            Problem(report, "/", "unterminated name in entry", i);
+            problems++;
+            continue;
+        }
+        if (table[i].Dir)
+        {
+            subtrees[numSubtrees].sector = table[i].sector;
+            snprintf(subtrees[numSubtrees].path, FsckPathLen, "/%s",
+                     table[i].name);
+            subtrees[numSubtrees].out = new List<char *>;
+            subtrees[numSubtrees].problems = 0;
+            numSubtrees++;
+        }
+        else
+        {
+            char path[FsckPathLen];
+
+            snprintf(path, FsckPathLen, "/%s", table[i].name);
+            problems += CheckTree(table[i].sector, path, FALSE, report);
+        }
+    }
+    delete[] contents;
+
+    DEBUG(dbgFile, "Checking " << numSubtrees << " directories in "
+                                 << FsckWorkers << " host threads.");
+    for (i = 0; i < FsckWorkers; i++)
+        workers[i] = StartHostThread(Worker, this);
+    for (i = 0; i < FsckWorkers; i++)
+        JoinHostThread(workers[i]);
+
+    for (i = 0; i < numSubtrees; i++)
+    {
+        while (!subtrees[i].out->IsEmpty())
+            report->Append(subtrees[i].out->RemoveFront());
+        delete subtrees[i].out;
+        problems += subtrees[i].problems;
+    }
+    return problems;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::Worker
+// 	Body of a host thread: take directories below the root until
+//	none are left, and walk each one.
+//
+//	"arg" -- the check being run
+//----------------------------------------------------------------------
+
+void *FileSystemCheck::Worker(void *arg)
+{
+    FileSystemCheck *check = (FileSystemCheck *)arg;
+    FsckSubtree *tree;
+    int i;
+
+    while ((i = __sync_fetch_and_add(&check->nextSubtree, 1)) < check->numSubtrees)
+    {
+        tree = &check->subtrees[i];
+        tree->problems = check->CheckTree(tree->sector, tree->path, TRUE,
+                                          tree->out);
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::ReadImage
+// 	Read the whole disk into memory, a track at a time, so the disk
+//	reads each track in one rotation.
+//----------------------------------------------------------------------
+
+void FileSystemCheck::ReadImage()
+{
+    int *sectors = new int[SectorsPerTrack];
+
+    image = new char[NumSectors * SectorSize];
+    for (int track = 0; track < NumTracks; track++)
+    {
+        for (int i = 0; i < SectorsPerTrack; i++)
+            sectors[i] = track * SectorsPerTrack + i;
+        kernel->synchDisk->ReadSectors(sectors,
+                                       image + track * SectorsPerTrack * SectorSize,
+                                       SectorsPerTrack);
+    }
+    delete[] sectors;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::Claim
+// 	Count one more use of "sector"; return how many uses it had
+//	before.  Safe to call from several host threads at once.
+//----------------------------------------------------------------------
+
+int FileSystemCheck::Claim(int sector)
+{
+    return __sync_fetch_and_add(&refs[sector], 1);
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::CheckHeader
+// 	Check the chain of file headers starting at "sector", and claim
+//	the headers and their data sectors.  If "contents" is not NULL,
+//	the data of the file is appended to the buffer it points to,
+//	holes as zeros; the buffer is grown with new[] as needed, and
+//	"size" holds the number of bytes in it.
+//
+//	A header already claimed is not followed again: it is either
+//	shared with another file or part of a loop, and its count will
+//	show it.
+//
+//	Return the number of problems found, described in "out".
+//
+//	"sector" -- the first header of the file
+//	"path" -- the name of the file, for the report
+//	"contents" -- where to put the file data, or NULL
+//	"size" -- bytes already in "*contents"
+//	"out" -- the report to add problems to
+//----------------------------------------------------------------------
+
+int FileSystemCheck::CheckHeader(int sector, const char *path,
+                                 char **contents, int *size,
+                                 List<char *> *out)
+{
+    DiskFileHeader *hdr;
+    char *grown;
+    int problems = 0;
+    int data, count;
+
+    while (sector != -1)
+    {
+        if (sector < 0 || sector >= NumSectors)
+        {
+            Problem(out, path, "header sector out of range", sector);
+            return problems + 1;
+        }
+        if (Claim(sector) > 0)
+            return problems;
+        hdr = (DiskFileHeader *)(image + sector * SectorSize);
+
+        if (hdr->numSectors < 0 || hdr->numSectors > (int)NumDirect ||
+            hdr->numBytes < 0 || hdr->numBytes > (int)MaxFileSize ||
+            hdr->numSectors != divRoundUp(hdr->numBytes, SectorSize))
+        {
+            Problem(out, path, "bad size in header", sector);
+            return problems + 1;
+        }
+        if (hdr->nextSector != -1 && hdr->numBytes != (int)MaxFileSize)
+        {
+            Problem(out, path, "short header in the middle of the chain", sector);
+            problems++;
+        }
+        if (contents != NULL && hdr->numBytes > 0)
+        {
+            grown = new char[*size + hdr->numBytes];
+            bcopy(*contents, grown, *size);
+            delete[] *contents;
+            *contents = grown;
+        }
+
+        for (int i = 0; i < hdr->numSectors; i++)
+        {
+            data = hdr->dataSectors[i];
+            if (data != NoSector && (data < 0 || data >= NumSectors))
+            {
+                Problem(out, path, "data sector out of range", data);
+                problems++;
+                data = NoSector;
+            }
+            if (data != NoSector)
+                Claim(data);
+            if (contents != NULL)
+            {
+                count = min(SectorSize, hdr->numBytes - i * SectorSize);
+                if (data == NoSector)
+                    bzero(*contents + *size, count);
+                else
+                    bcopy(image + data * SectorSize, *contents + *size, count);
+                *size += count;
+            }
+        }
+        sector = hdr->nextSector;
+    }
+    return problems;
+}
+
+//----------------------------------------------------------------------
+// FileSystemCheck::CheckTree
+// 	Check the file whose header is at "sector".  If it is a directory,
+//	check every file and directory in it as well.
+//
+//	Return the number of problems found, described in "out".
+//
+//	"sector" -- the header of the file
+//	"path" -- the full name of the file
+//	"isDir" -- is the file a directory?
+//	"out" -- the report to add problems to
+//----------------------------------------------------------------------
+
+int FileSystemCheck::CheckTree(int sector, const char *path, bool isDir,
+                               List<char *> *out)
+{
+    char *contents = NULL;
+    char child[FsckPathLen];
+    DirectoryEntry *table;
+    int problems, numEntries, size = 0;
+
+    if (!isDir)
+        return CheckHeader(sector, path, NULL, NULL, out);
+
+    // A directory reached before (a loop, or shared with another entry)
+    // comes back empty, so it is only walked once.
+    problems = CheckHeader(sector, path, &contents, &size, out);
+    if (size % sizeof(DirectoryEntry) != 0)
+    {
+        Problem(out, path, "directory size is not a number of entries", size);
+        problems++;
+    }
+    table = (DirectoryEntry *)contents;
+    numEntries = size / sizeof(DirectoryEntry);
+    for (int i = 0; i < numEntries; i++)
+    {
+        if (!table[i].inUse)
+            continue;
+        if (table[i].name[FileNameMaxLen] != '\0')
+        {
+            Problem(out, path, "unterminated name in entry", i);
+            problems++;
+            continue;
+        }
+        snprintf(child, FsckPathLen, "%s/%s", path, table[i].name);
+        problems += CheckTree(table[i].sector, child, table[i].Dir, out);
+    }
+    delete[] contents;
+    return problems;
+}
@@ -0,0 +1,77 @@
+// fsck.h
+//	Data structures to check the file system on disk for consistency.
+//
+//	The check reads the whole disk into memory in one pass, then
+//	walks every file header reachable from the root directory,
+//	counting how many times each sector is claimed.  Directories
+//	just below the root are walked by several host threads at once.
+//	They only touch the copy of the disk in memory, and a claim is a
+//	single atomic add, so the counts do not depend on the order the
+//	threads run in.  Which path a header shared by two files or
+//	directories is walked (and its problems reported) under does:
+//	the first thread to claim it wins.
+//
+//	FileSystem::Check then compares the counts with the free map.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FSCK_H
+#define FSCK_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "list.h"
+
+#define FsckWorkers 4   // host threads walking directories
+#define FsckPathLen 256 // longest name in the report; longer
+                        // names are cut short
+
+class FsckSubtree;
+
+// The following class defines one run of the checker.  Problems in
+// file headers and directories are counted and collected in a report;
+// what each sector is used for is left in a count per sector.
+
+class FileSystemCheck
+{
+public:
+    FileSystemCheck();  // Set up an empty check
+    ~FileSystemCheck(); // De-allocate the copy of the disk
+
+    void Reserve(int first, int count);
+    // Sectors in use outside of any
+    // file (the journal)
+    int Run(int mapSector, int rootSector);
+    // Read the disk and walk the free map
+    // file and the directory tree; return
+    // the number of problems found
+
+    int RefCount(int sector) { return refs[sector]; }
+    // How many times "sector" is used
+    void PrintReport(); // One line per problem found
+
+private:
+    char *image;        // the whole disk, read by Run
+    int *refs;          // times each sector was claimed
+    List<char *> *report; // problems, in the order of the walk
+
+    FsckSubtree *subtrees; // directories just below the root
+    int numSubtrees;
+    int nextSubtree;       // next one for a worker to take
+
+    void ReadImage(); // Read every sector of the disk
+    int Claim(int sector); // Count one more use of "sector"
+    int CheckHeader(int sector, const char *path, char **contents,
+                    int *size, List<char *> *out);
+    // Check a chain of file headers, and
+    // optionally collect the file data
+    int CheckTree(int sector, const char *path, bool isDir,
+                  List<char *> *out);
+    // Check a file, or a directory and
+    // everything below it
+    static void *Worker(void *arg); // Host thread: walk subtrees
+};
+
+#endif // FSCK_H
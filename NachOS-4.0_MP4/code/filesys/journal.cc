@@ -0,0 +1,493 @@
+// journal.cc
+//	Routines to keep a write-ahead log of file system metadata.
+//
+//	On disk, a committed transaction of "n" sectors looks like this,
+//	starting at JournalStart:
+//
+//	   descriptor	JournalMagic, sequence number, n, and the home
+//			sector of each entry (continued over as many
+//			sectors as needed, see JournalDescSectors)
+//	   n sectors	the data of each entry, in the same order
+//	   commit	JournalCommitMagic, sequence number, n, checksum
+//
+//	All of it is written in one pass over consecutive sectors.  Once
+//	the entries have been installed at their home locations, the
+//	descriptor is overwritten with JournalEmpty to mark the log clear.
+//
+//	A disk formatted before the log existed has neither magic number
+//	in the first log sector; the log is then left disabled, and
+//	writes go straight to their home locations as before.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "journal.h"
+#include "synchdisk.h"
+#include "synch.h"
+#include "main.h"
+
+#define JournalMagic 0x4a4e4c31       // "JNL1", descriptor of a transaction
+#define JournalEmpty 0x4a4e4c30       // "JNL0", log is clear
+#define JournalCommitMagic 0x434d5431 // "CMT1", transaction is complete
+
+//----------------------------------------------------------------------
+// EntrySector, HashSector
+//	Key and hash functions for the table of entries in the current
+//	transaction.
+//----------------------------------------------------------------------
+
+static int
+EntrySector(JournalEntry *entry)
+{
+    return entry->sector;
+}
+
+static unsigned
+HashSector(int sector)
+{
+    return (unsigned)sector;
+}
+
+//----------------------------------------------------------------------
+// Checksum
+//	Fold the contents of a sector into a running checksum, so that a
+//	commit record left behind by a partly written log is detected.
+//----------------------------------------------------------------------
+
+static unsigned
+Checksum(unsigned sum, char *data)
+{
+    unsigned *words = (unsigned *)data;
+
+    for (unsigned int i = 0; i < SectorSize / sizeof(unsigned); i++)
+        sum = sum * 31 + words[i];
+    return sum;
+}
+
+//----------------------------------------------------------------------
+// Journal::Journal
+// 	Initialize an empty log.  It stays disabled until Format or
+//	Recover finds (or puts) a log area on the disk.
+//----------------------------------------------------------------------
+
+Journal::Journal()
+{
+    entries = new List<JournalEntry *>;
+    index = new HashTable<int, JournalEntry *>(EntrySector, HashSector);
+    depth = 0;
+    owner = NULL;
+    sequence = 1;
+    firstTick = 0;
+    committing = FALSE;
+    committer = NULL;
+    enabled = FALSE;
+    lock = new Lock("journal");
+    commitDone = new Condition("journal commit");
+    operationDone = new Condition("journal operation");
+    due = new Semaphore("journal timer", 0);
+    flusher = NULL;
+}
+
+//----------------------------------------------------------------------
+// Journal::~Journal
+// 	De-allocate the log.  Anything not yet committed is lost; call
+//	Sync first to keep it.
+//----------------------------------------------------------------------
+
+Journal::~Journal()
+{
+    while (!entries->IsEmpty())
+        delete entries->RemoveFront();
+    delete index;
+    delete entries;
+    delete due;
+    delete operationDone;
+    delete commitDone;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// Journal::Format
+// 	Set up the log on a freshly formatted disk: keep the log area
+//	out of the free map, and mark the log clear.
+//
+//	"freeMap" -- the free map being built for the new disk
+//----------------------------------------------------------------------
+
+void Journal::Format(PersistentBitmap *freeMap)
+{
+    for (int i = 0; i < JournalSectors; i++)
+        freeMap->Mark(JournalStart + i);
+    enabled = TRUE;
+    Clear();
+}
+
+//----------------------------------------------------------------------
+// Journal::Recover
+// 	Called when the file system is mounted.  If the log holds a
+//	complete transaction, copy its sectors to their home locations,
+//	then mark the log clear.  An incomplete transaction is dropped:
+//	none of its sectors were written home.
+//----------------------------------------------------------------------
+
+void Journal::Recover()
+{
+    char sector[SectorSize];
+    int *header = (int *)sector;
+    int *desc, *targets;
+    char *data;
+    int count, descSectors, i;
+    unsigned sum = 0;
+
+    kernel->synchDisk->ReadSector(JournalStart, sector);
+    if (header[0] != JournalMagic && header[0] != JournalEmpty)
+    {
+        DEBUG(dbgFile, "No journal on this disk.");
+        return;
+    }
+    enabled = TRUE;
+    sequence = header[1] + 1;
+    count = header[2];
+    if (header[0] == JournalEmpty)
+        return;
+    if (count <= 0 || count > JournalMaxEntries)
+    {
+        Clear();
+        return;
+    }
+
+    descSectors = JournalDescSectors(count);
+    desc = new int[descSectors * JournalMoreTargets];
+    bcopy(sector, (char *)desc, SectorSize);
+    for (i = 1; i < descSectors; i++)
+        kernel->synchDisk->ReadSector(JournalStart + i,
+                                      (char *)desc + i * SectorSize);
+    targets = desc + 3;
+
+    data = new char[count * SectorSize];
+    for (i = 0; i < count; i++)
+    {
+        kernel->synchDisk->ReadSector(JournalStart + descSectors + i,
+                                      data + i * SectorSize);
+        sum = Checksum(sum, data + i * SectorSize);
+    }
+    kernel->synchDisk->ReadSector(JournalStart + descSectors + count, sector);
+
+    if (header[0] == JournalCommitMagic && header[1] == desc[1] &&
+        header[2] == count && (unsigned)header[3] == sum)
+    {
+        DEBUG(dbgFile, "Replaying journal transaction " << desc[1]
+                           << ", " << count << " sectors.");
+        Install(count, targets, data);
+    }
+    else
+        DEBUG(dbgFile, "Dropping uncommitted journal transaction " << desc[1]);
+    Clear();
+
+    delete[] data;
+    delete[] desc;
+}
+
+//----------------------------------------------------------------------
+// Journal::Begin, Journal::End
+// 	Bracket a file system operation.  Sectors written in between by
+//	the same thread are kept in the current transaction; an operation
+//	started by another thread waits in Begin until this one is over.
+//	Operations may nest.
+//
+//	The transaction is committed at the end of an operation once
+//	enough sectors are waiting, or once the first of them has waited
+//	JournalCommitDelay ticks, so it always holds whole operations.
+//----------------------------------------------------------------------
+
+void Journal::Begin()
+{
+    lock->Acquire();
+    while (owner != NULL && owner != kernel->currentThread)
+        operationDone->Wait(lock);
+    owner = kernel->currentThread;
+    depth++;
+    lock->Release();
+}
+
+void Journal::End()
+{
+    ASSERT(owner == kernel->currentThread && depth > 0);
+    if (depth == 1 && !entries->IsEmpty() &&
+        (entries->NumInList() >= JournalCommitThreshold || Aged()))
+        Commit();
+    lock->Acquire();
+    depth--;
+    if (depth == 0)
+    {
+        owner = NULL;
+        operationDone->Broadcast(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::Aged
+// 	Return TRUE if the oldest sector in the current transaction has
+//	waited JournalCommitDelay ticks or more.
+//----------------------------------------------------------------------
+
+bool Journal::Aged()
+{
+    return !entries->IsEmpty() &&
+           kernel->stats->totalTicks - firstTick >= JournalCommitDelay;
+}
+
+//----------------------------------------------------------------------
+// Journal::CallBack
+// 	Called by the timer set when the first sector of a transaction
+//	was logged.  Disk I/O can not be done in an interrupt handler,
+//	so wake up the flusher thread to commit the transaction.  A
+//	timer left over from a transaction already committed just finds
+//	nothing old enough.
+//----------------------------------------------------------------------
+
+void Journal::CallBack()
+{
+    due->V();
+}
+
+//----------------------------------------------------------------------
+// Journal::Flusher
+// 	Body of the kernel thread that commits transactions that have
+//	waited too long while no operation ends.  The empty operation
+//	waits for any operation in progress, and End commits if the
+//	transaction is old enough.
+//
+//	"arg" -- the journal
+//----------------------------------------------------------------------
+
+void Journal::Flusher(void *arg)
+{
+    Journal *journal = (Journal *)arg;
+
+    for (;;)
+    {
+        journal->due->P();
+        journal->Begin();
+        journal->End();
+    }
+}
+
+//----------------------------------------------------------------------
+// Journal::Sync
+// 	Commit the current transaction now.  Used before Nachos halts,
+//	and after an operation that frees sectors, so that a later file
+//	can not write its data over them while the free is only in memory.
+//	An operation in another thread is waited for, so the transaction
+//	only holds whole operations; the caller must not be inside one.
+//----------------------------------------------------------------------
+
+void Journal::Sync()
+{
+    Begin();
+    ASSERT(depth == 1);
+    Commit();
+    End();
+}
+
+//----------------------------------------------------------------------
+// Journal::Absorb
+// 	Called for every sector write.  If the sector already has a copy
+//	in the current transaction, or the write is made by the thread
+//	running an operation, keep the data there and return TRUE; the
+//	write must not go to disk.  Otherwise return FALSE.
+//
+//	When the log is full, a new sector is written straight home
+//	(FALSE is returned) rather than logged.  The operation is then
+//	no longer atomic, but it goes through.
+//
+//	The writes of a commit go to disk.  Any other thread writing
+//	while a commit is going on waits for it to finish first, so it
+//	can not write a sector that the commit then overwrites with an
+//	older copy.
+//
+//	"sector" -- the disk sector being written
+//	"data" -- the new contents of the sector
+//----------------------------------------------------------------------
+
+bool Journal::Absorb(int sector, char *data)
+{
+    JournalEntry *entry;
+    bool absorbed = TRUE;
+
+    if (!enabled)
+        return FALSE;
+    if (committing && committer == kernel->currentThread)
+        return FALSE;
+
+    lock->Acquire();
+    while (committing)
+        commitDone->Wait(lock);
+    if (index->Find(sector, &entry))
+        bcopy(data, entry->data, SectorSize);
+    else if (owner != kernel->currentThread)
+        absorbed = FALSE;
+    else if (entries->NumInList() >= JournalMaxEntries)
+    {
+        DEBUG(dbgFile, "Journal full, writing sector " << sector
+                           << " in place.");
+        absorbed = FALSE;
+    }
+    else
+    {
+        if (entries->IsEmpty())
+        {
+            firstTick = kernel->stats->totalTicks;
+            if (flusher == NULL)
+            {
+                flusher = new Thread("journal flusher", 1);
+                flusher->Fork(Flusher, this);
+            }
+            kernel->interrupt->Schedule(this, JournalCommitDelay, DiskInt);
+        }
+        entry = new JournalEntry;
+        entry->sector = sector;
+        bcopy(data, entry->data, SectorSize);
+        entries->Append(entry);
+        index->Insert(entry);
+    }
+    lock->Release();
+    return absorbed;
+}
+
+//----------------------------------------------------------------------
+// Journal::Lookup
+// 	Called for every sector read.  If the current transaction holds
+//	the sector, copy it into "data" and return TRUE.
+//
+//	"sector" -- the disk sector being read
+//	"data" -- the buffer to hold the contents of the sector
+//----------------------------------------------------------------------
+
+bool Journal::Lookup(int sector, char *data)
+{
+    JournalEntry *entry;
+
+    if (entries->IsEmpty() || !index->Find(sector, &entry))
+        return FALSE;
+    bcopy(entry->data, data, SectorSize);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Journal::Commit
+// 	Write the current transaction to the log in one sequential pass,
+//	followed by its commit record.  From then on the transaction
+//	survives a crash, so its sectors can be written home.
+//----------------------------------------------------------------------
+
+void Journal::Commit()
+{
+    JournalEntry *entry;
+    int count, descSectors;
+    int *desc;
+    int record[SectorSize / sizeof(int)];
+    unsigned sum = 0;
+    int i;
+
+    lock->Acquire();
+    while (committing)
+        commitDone->Wait(lock); // another thread got here first
+    count = entries->NumInList();
+    if (count == 0)
+    {
+        lock->Release();
+        return;
+    }
+    committing = TRUE;
+    committer = kernel->currentThread;
+    lock->Release();
+
+    descSectors = JournalDescSectors(count);
+
+    desc = new int[descSectors * JournalMoreTargets];
+    bzero((char *)desc, descSectors * SectorSize);
+    desc[0] = JournalMagic;
+    desc[1] = sequence;
+    desc[2] = count;
+    ListIterator<JournalEntry *> iter(entries);
+    for (i = 0; !iter.IsDone(); iter.Next(), i++)
+    {
+        desc[3 + i] = iter.Item()->sector;
+        sum = Checksum(sum, iter.Item()->data);
+    }
+    bzero((char *)record, SectorSize);
+    record[0] = JournalCommitMagic;
+    record[1] = sequence;
+    record[2] = count;
+    record[3] = (int)sum;
+
+    DEBUG(dbgFile, "Committing journal transaction " << sequence
+                       << ", " << count << " sectors.");
+    for (i = 0; i < descSectors; i++)
+        kernel->synchDisk->WriteSector(JournalStart + i,
+                                       (char *)desc + i * SectorSize);
+    ListIterator<JournalEntry *> logIter(entries);
+    for (i = 0; !logIter.IsDone(); logIter.Next(), i++)
+        kernel->synchDisk->WriteSector(JournalStart + descSectors + i,
+                                       logIter.Item()->data);
+    kernel->synchDisk->WriteSector(JournalStart + descSectors + count,
+                                   (char *)record);
+
+    while (!entries->IsEmpty())
+    {
+        entry = entries->RemoveFront();
+        kernel->synchDisk->WriteSector(entry->sector, entry->data);
+        index->Remove(entry->sector);
+        delete entry;
+    }
+    Clear();
+    kernel->stats->numJournalCommits++;
+    kernel->stats->numJournalSectors += count;
+    sequence++;
+    delete[] desc;
+
+    lock->Acquire();
+    committing = FALSE;
+    committer = NULL;
+    commitDone->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::Install
+// 	Write the entries of a transaction found in the log to their
+//	home locations.
+//
+//	"count" -- the number of entries
+//	"targets" -- the home sector of each entry
+//	"data" -- the contents of each entry, one sector after another
+//----------------------------------------------------------------------
+
+void Journal::Install(int count, int *targets, char *data)
+{
+    for (int i = 0; i < count; i++)
+    {
+        ASSERT(targets[i] >= 0 && targets[i] < JournalStart);
+        kernel->synchDisk->WriteSector(targets[i], data + i * SectorSize);
+    }
+}
+
+//----------------------------------------------------------------------
+// Journal::Clear
+// 	Mark the log empty on disk, keeping the sequence number so that
+//	the next transaction gets a new one.
+//----------------------------------------------------------------------
+
+void Journal::Clear()
+{
+    int header[SectorSize / sizeof(int)];
+
+    bzero((char *)header, SectorSize);
+    header[0] = JournalEmpty;
+    header[1] = sequence;
+    kernel->synchDisk->WriteSector(JournalStart, (char *)header);
+}
@@ -0,0 +1,142 @@
+// journal.h
+//	Data structures for a write-ahead log of file system metadata.
+//
+//	Operations that change the file system structures (Create,
+//	Remove, CreateDirectory) are bracketed by Begin and End.  The
+//	sectors they write are not sent to their home location on disk;
+//	they are kept in memory instead, and several operations are
+//	grouped into one transaction.  Writing the same sector again
+//	(the directory is rewritten by every operation) just replaces
+//	the copy in memory.
+//
+//	One thread at a time runs an operation; the others wait in
+//	Begin.  Only the sectors written by that thread start new log
+//	entries.  An operation that would overflow the log has the rest
+//	of its new sectors written straight home instead.
+//
+//	A transaction is committed at the end of an operation once
+//	enough sectors are waiting.  A timer also wakes a kernel thread
+//	once the first sector has waited long enough, so a quiet file
+//	system does not keep changes only in memory for long.  Other
+//	threads writing to the disk wait until a commit is over.
+//
+//	A transaction is committed by writing all of its sectors, with a
+//	descriptor in front and a commit record behind, to a region of
+//	consecutive sectors at the end of the disk.  Only then are the
+//	sectors written to their home locations.  If Nachos stops before
+//	that is finished, Recover copies the log to its home locations
+//	the next time the file system is mounted; a transaction without
+//	a valid commit record is ignored.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "list.h"
+#include "hash.h"
+#include "pbitmap.h"
+#include "stats.h"
+#include "callback.h"
+
+class Lock;
+class Condition;
+class Semaphore;
+class Thread;
+
+#define JournalMaxEntries 2048 // sectors in one transaction
+#define JournalCommitThreshold (JournalMaxEntries / 2)
+                               // commit once this many sectors
+                               // are waiting
+#define JournalCommitDelay (16 * SectorsPerTrack * RotationTime)
+                               // or once the oldest has waited
+                               // this many ticks (16 rotations)
+
+// Sector targets listed in the first descriptor sector, and in each
+// following one.
+#define JournalFirstTargets ((int)(SectorSize / sizeof(int)) - 3)
+#define JournalMoreTargets ((int)(SectorSize / sizeof(int)))
+
+// Number of descriptor sectors needed for "n" log entries.
+#define JournalDescSectors(n) \
+    (1 + (((n) > JournalFirstTargets) ? \
+          divRoundUp((n) - JournalFirstTargets, JournalMoreTargets) : 0))
+
+// The log lives in the last sectors of the disk.
+#define JournalSectors (JournalDescSectors(JournalMaxEntries) + \
+                        JournalMaxEntries + 1)
+#define JournalStart (NumSectors - JournalSectors)
+
+// The following class defines a sector written during the current
+// transaction, that has not reached its home location yet.
+
+class JournalEntry
+{
+public:
+    int sector;            // home location of the data
+    char data[SectorSize]; // latest contents written
+};
+
+// The following class defines the log.  The synchronous disk hands
+// it every read and write, so that sectors written in a transaction
+// are seen by later reads before they are on disk.  It is called
+// back by the timer it sets for the oldest waiting sector.
+
+class Journal : public CallBackObj
+{
+public:
+    Journal();  // Initialize an empty log
+    ~Journal(); // De-allocate the log
+
+    void Format(PersistentBitmap *freeMap);
+    // Reserve the log area and clear it
+    void Recover(); // Replay a committed transaction
+                    // left in the log, at mount
+
+    void Begin(); // Start a file system operation,
+                  // once no other thread has one
+    void End();   // Finish it, committing the
+                  // transaction if it is big enough
+    void Sync();  // Commit whatever is waiting
+    bool IsEnabled() { return enabled; }
+                  // Does the disk have a log area?
+
+    bool Absorb(int sector, char *data);
+    // Keep a sector write in the current
+    // transaction, if it belongs there
+    bool Lookup(int sector, char *data);
+    // Read the latest copy of a sector
+    // from the current transaction
+
+    void CallBack(); // The oldest entry may be due
+
+private:
+    List<JournalEntry *> *entries;              // in order of first write
+    HashTable<int, JournalEntry *> *index;      // the same, by sector
+    int depth;        // nesting of Begin/End in "owner"
+    Thread *owner;    // the thread running an operation
+    int sequence;     // number of the next transaction
+    int firstTick;    // when the oldest entry was written
+    bool committing;  // are log writes going to the disk now?
+    Thread *committer; // the thread writing them
+    bool enabled;     // does the disk have a log area?
+    Lock *lock;       // protects "committing", "owner" and
+                      // the entries
+    Condition *commitDone; // signalled when a commit is over
+    Condition *operationDone; // signalled when "owner" is cleared
+    Semaphore *due;   // the timer has gone off
+    Thread *flusher;  // commits aged transactions
+
+    bool Aged();        // Has the oldest entry waited long enough?
+    static void Flusher(void *arg); // Body of "flusher"
+    void Commit();      // Write the log, then install it
+    void Install(int count, int *targets, char *data);
+                        // Write the log entries home
+    void Clear();       // Mark the log empty on disk
+};
+
+#endif // JOURNAL_H
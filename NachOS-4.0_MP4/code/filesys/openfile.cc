@@ -31,16 +31,46 @@ OpenFile::OpenFile(int sector)
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
     seekPosition = 0;
+    hdrSector = sector;
+    sharedTable = NULL;
+    lastReadEnd = 0;
+    readAheadWindow = 0;
+    readAheadEnd = 0;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::OpenFile(int, OpenFileTable*)
+// 	Open a Nachos file whose header is kept in the system-wide open
+//	file table.  The header is only read from disk if no other handle
+//	on the same file is open.
+//
+//	"sector" -- the location on disk of the file header for this file
+//	"table" -- the open file table sharing the header
+//----------------------------------------------------------------------
+
+OpenFile::OpenFile(int sector, OpenFileTable *table)
+{
+    hdr = table->Acquire(sector);
+    seekPosition = 0;
+    hdrSector = sector;
+    sharedTable = table;
+    lastReadEnd = 0;
+    readAheadWindow = 0;
+    readAheadEnd = 0;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	A shared header is handed back to the open file table instead.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
-    delete hdr;
+    if (sharedTable != NULL)
+        sharedTable->Release(hdrSector);
+    else
+        delete hdr;
 }
 
 //----------------------------------------------------------------------
@@ -72,6 +102,7 @@ void OpenFile::Seek(int position)
 int OpenFile::Read(char *into, int numBytes)
 {
     int result = ReadAt(into, numBytes, seekPosition);
+    ReadAhead(seekPosition, result);
     seekPosition += result;
     return result;
 }
@@ -83,6 +114,49 @@ int OpenFile::Write(char *into, int numBytes)
     return result;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::ReadAhead
+// 	After a Read, ask the disk to fetch the following sectors of the
+//	file in the background, so the next sequential Read finds them
+//	in memory instead of waiting for the disk.
+//
+//	The window starts at MinReadAhead sectors and doubles, up to
+//	MaxReadAhead, every time a Read starts where the previous one
+//	ended.  Any other access pattern turns read-ahead off until the
+//	reads become sequential again.
+//
+//	"position" -- where the Read started
+//	"numBytes" -- how many bytes it returned
+//----------------------------------------------------------------------
+
+void OpenFile::ReadAhead(int position, int numBytes)
+{
+    int fileSectors = divRoundUp(hdr->FileLength(), SectorSize);
+    int i, first, last, sector;
+
+    if (numBytes <= 0)
+        return;
+    if (position == lastReadEnd)
+        readAheadWindow = (readAheadWindow == 0) ? MinReadAhead
+                                                 : min(2 * readAheadWindow, MaxReadAhead);
+    else
+    {
+        readAheadWindow = 0;
+        readAheadEnd = 0;
+    }
+    lastReadEnd = position + numBytes;
+
+    first = max(divRoundDown(lastReadEnd, SectorSize), readAheadEnd);
+    last = min(divRoundDown(lastReadEnd, SectorSize) + readAheadWindow, fileSectors);
+    for (i = first; i < last; i++)
+    {
+        sector = hdr->ByteToSector(i * SectorSize);
+        if (sector != NoSector) // nothing to read in a hole
+            kernel->synchDisk->Prefetch(sector);
+    }
+    readAheadEnd = max(readAheadEnd, last);
+}
+
 //----------------------------------------------------------------------
 // OpenFile::ReadAt/WriteAt
 // 	Read/write a portion of a file, starting at "position".
@@ -95,12 +169,16 @@ int OpenFile::Write(char *into, int numBytes)
 //
 //	For ReadAt:
 //	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   request, but we only copy the part we are interested in.  Holes
+//	   in a sparse file read as zeros.
 //	For WriteAt:
 //	   We must first read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   or partial sectors that are part of the request.  Writing past
+//	   the end of the file grows it, and writing into a hole gives it
+//	   a disk block; if the disk fills up, only the part of the request
+//	   that got blocks is written.
 //
 //	"into" -- the buffer to contain the data to be read from disk
 //	"from" -- the buffer containing the data to be written to disk
@@ -112,7 +190,8 @@ int OpenFile::Write(char *into, int numBytes)
 int OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
+    int i, firstSector, lastSector, numSectors, run;
+    int *sectors;
     char *buf;
 
     if ((numBytes <= 0) || (position >= fileLength))
@@ -126,11 +205,25 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    // read in all the full and partial sectors that we need
+    // read in all the full and partial sectors that we need, a run of
+    // allocated sectors at a time
     buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize),
-                                      &buf[(i - firstSector) * SectorSize]);
+    sectors = new int[numSectors];
+    for (i = 0; i < numSectors; i++)
+        sectors[i] = hdr->ByteToSector((firstSector + i) * SectorSize);
+    for (i = 0; i < numSectors; i += run)
+    {
+        if (sectors[i] == NoSector)
+        {
+            memset(&buf[i * SectorSize], 0, SectorSize);
+            run = 1;
+            continue;
+        }
+        for (run = 1; i + run < numSectors && sectors[i + run] != NoSector; run++)
+            ;
+        kernel->synchDisk->ReadSectors(&sectors[i], &buf[i * SectorSize], run);
+    }
+    delete[] sectors;
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
@@ -142,13 +235,12 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
+    bool firstAligned, lastAligned, holes = FALSE;
+    int *sectors;
     char *buf;
 
-    if ((numBytes <= 0) || (position >= fileLength))
+    if ((numBytes <= 0) || (position < 0))
         return 0; // check request
-    if ((position + numBytes) > fileLength)
-        numBytes = fileLength - position;
     DEBUG(dbgFile, "Writing " << numBytes << " bytes at " << position << " from file of length " << fileLength);
 
     firstSector = divRoundDown(position, SectorSize);
@@ -172,14 +264,44 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     // copy in the bytes we want to change
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
-    // write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize),
-                                       &buf[(i - firstSector) * SectorSize]);
+    // give the sectors disk blocks, if they don't have them yet
+    for (i = firstSector; i <= lastSector && !holes; i++)
+        holes = (hdr->ByteToSector(i * SectorSize) == NoSector);
+    if (holes || (position + numBytes) > fileLength)
+        kernel->fileSystem->AllocateBlocks(hdrSector, hdr, position,
+                                           position + numBytes);
+
+    // write modified sectors back in one batch, stopping at the first
+    // one the disk had no room for
+    sectors = new int[numSectors];
+    for (i = 0; i < numSectors; i++)
+    {
+        sectors[i] = hdr->ByteToSector((firstSector + i) * SectorSize);
+        if (sectors[i] == NoSector)
+        {
+            numBytes = max((firstSector + i) * SectorSize - position, 0);
+            break;
+        }
+    }
+    kernel->synchDisk->WriteSectors(sectors, buf, i);
+    delete[] sectors;
     delete[] buf;
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::Reserve
+// 	Give the first "numBytes" bytes of the file disk blocks now,
+//	growing it if needed, so that a large file written afterwards
+//	sits in one run of sectors and its header and the free map are
+//	only updated once.  Return FALSE if the disk is full.
+//----------------------------------------------------------------------
+
+bool OpenFile::Reserve(int numBytes)
+{
+    return kernel->fileSystem->AllocateBlocks(hdrSector, hdr, 0, numBytes);
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Length
 // 	Return the number of bytes in the file.
@@ -190,4 +312,114 @@ int OpenFile::Length()
     return hdr->FileLength();
 }
 
+//----------------------------------------------------------------------
+// OpenFileTable::OpenFileTable
+// 	Initialize an empty system-wide open file table.
+//----------------------------------------------------------------------
+
+OpenFileTable::OpenFileTable()
+{
+    entries = new List<OpenFileEntry *>;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::~OpenFileTable
+// 	De-allocate the table, along with any headers still cached in it.
+//----------------------------------------------------------------------
+
+OpenFileTable::~OpenFileTable()
+{
+    while (!entries->IsEmpty())
+    {
+        OpenFileEntry *entry = entries->RemoveFront();
+        delete entry->hdr;
+        delete entry;
+    }
+    delete entries;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::FindEntry
+// 	Return the entry for the file whose header is at "sector", or
+//	NULL if that file isn't currently open.
+//----------------------------------------------------------------------
+
+OpenFileEntry *OpenFileTable::FindEntry(int sector)
+{
+    ListIterator<OpenFileEntry *> it(entries);
+
+    for (; !it.IsDone(); it.Next())
+        if (it.Item()->sector == sector)
+            return it.Item();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Open
+// 	Return a new handle, with its own seek position, on the file
+//	whose header is located at "sector".
+//----------------------------------------------------------------------
+
+OpenFile *OpenFileTable::Open(int sector)
+{
+    return new OpenFile(sector, this);
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Acquire
+// 	Return the shared in-memory header of the file at "sector", taking
+//	a reference on it.  The header is fetched from disk only when the
+//	file is not open yet.
+//----------------------------------------------------------------------
+
+FileHeader *OpenFileTable::Acquire(int sector)
+{
+    OpenFileEntry *entry = FindEntry(sector);
+
+    if (entry == NULL)
+    {
+        entry = new OpenFileEntry;
+        entry->sector = sector;
+        entry->hdr = new FileHeader;
+        entry->hdr->FetchFrom(sector);
+        entry->refCount = 0;
+        entries->Append(entry);
+        DEBUG(dbgFile, "Caching header of file at sector " << sector);
+    }
+    entry->refCount++;
+    return entry->hdr;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Release
+// 	Drop a reference on the header of the file at "sector".  When the
+//	last handle on the file is closed, the header is freed.
+//----------------------------------------------------------------------
+
+void OpenFileTable::Release(int sector)
+{
+    OpenFileEntry *entry = FindEntry(sector);
+
+    ASSERT(entry != NULL && entry->refCount > 0);
+    if (--entry->refCount == 0)
+    {
+        entries->Remove(entry);
+        delete entry->hdr;
+        delete entry;
+        DEBUG(dbgFile, "Dropping header of file at sector " << sector);
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::RefCount
+// 	Return the number of open handles on the file at "sector".
+//----------------------------------------------------------------------
+
+int OpenFileTable::RefCount(int sector)
+{
+    OpenFileEntry *entry = FindEntry(sector);
+
+    return (entry == NULL) ? 0 : entry->refCount;
+}
+
 #endif // FILESYS_STUB
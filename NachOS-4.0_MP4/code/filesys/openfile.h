@@ -23,6 +23,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "sysdep.h"
+#include "list.h"
 
 #ifdef FILESYS_STUB // Temporarily implement calls to
 					// Nachos file system as calls to UNIX!
@@ -74,12 +75,19 @@ private:
 
 #else // FILESYS
 class FileHeader;
+class OpenFileTable;
+
+#define MinReadAhead 1 // sectors read ahead once access looks sequential
+#define MaxReadAhead 8 // largest read-ahead window, in sectors
 
 class OpenFile
 {
 public:
 	OpenFile(int sector); // Open a file whose header is located
 						  // at "sector" on the disk
+	OpenFile(int sector, OpenFileTable *table);
+						  // Open a file whose in-memory header
+						  // is shared through "table"
 	~OpenFile();		  // Close the file
 
 	void Seek(int position); // Set the position from which to
@@ -96,6 +104,9 @@ public:
 	// bypassing the implicit position.
 	int WriteAt(char *from, int numBytes, int position);
 
+	bool Reserve(int numBytes); // Allocate disk blocks for the
+								// first "numBytes" bytes up front
+
 	int Length(); // Return the number of bytes in the
 				  // file (this interface is simpler
 				  // than the UNIX idiom -- lseek to
@@ -104,6 +115,56 @@ public:
 private:
 	FileHeader *hdr;  // Header for this file
 	int seekPosition; // Current position within the file
+	int hdrSector;	  // Disk sector holding the file header
+	OpenFileTable *sharedTable; // Table the header is borrowed from,
+								// NULL if this handle owns "hdr"
+
+	int lastReadEnd;	 // Position right after the previous Read
+	int readAheadWindow; // Sectors to read ahead, 0 if access is random
+	int readAheadEnd;	 // First sector of the file not yet read ahead
+
+	void ReadAhead(int position, int numBytes); // Prefetch the sectors
+												// following a Read
+};
+
+// The following class defines the system-wide open file table.
+//
+// Every file that is open at least once has exactly one entry here,
+// holding the in-memory copy of its file header and the number of
+// OpenFile handles currently using it.  Handles opened through the
+// table share that header, so opening a file a second time does not
+// read the header off of disk again, and all handles agree on the
+// file's layout.  The header is freed when the last handle is closed.
+
+class OpenFileEntry
+{
+public:
+	int sector;		  // Disk sector of the file header
+	FileHeader *hdr;  // Shared in-memory copy of the header
+	int refCount;	  // Number of open handles using "hdr"
+};
+
+class OpenFileTable
+{
+public:
+	OpenFileTable();  // Initialize an empty table
+	~OpenFileTable(); // De-allocate the table and any cached headers
+
+	OpenFile *Open(int sector); // Return a new handle on the file whose
+								// header is at "sector"
+
+	FileHeader *Acquire(int sector); // Take a reference on the header
+									 // at "sector", reading it from
+									 // disk on the first open
+	void Release(int sector);		 // Drop a reference; the header is
+									 // freed with the last one
+
+	int RefCount(int sector); // Number of handles open on "sector"
+
+private:
+	List<OpenFileEntry *> *entries; // Currently open files
+
+	OpenFileEntry *FindEntry(int sector); // NULL if "sector" isn't open
 };
 
 #endif // FILESYS
@@ -16,11 +16,16 @@
 //
 //	"numItems" is the number of bits in the bitmap.
 //
-//      This constructor does not initialize the bitmap from a disk file
+//      This constructor does not initialize the bitmap from a disk file,
+//      so all of it is written by the first WriteBack
 //----------------------------------------------------------------------
 
 PersistentBitmap::PersistentBitmap(int numItems) : Bitmap(numItems)
 {
+    numFileSectors = divRoundUp(numWords * sizeof(unsigned), SectorSize);
+    dirty = new Bitmap(numFileSectors);
+    for (int i = 0; i < numFileSectors; i++)
+        dirty->Mark(i);
 }
 
 //----------------------------------------------------------------------
@@ -40,7 +45,9 @@ PersistentBitmap::PersistentBitmap(OpenFile *file, int numItems) : Bitmap(numIte
     // map has already been initialized by the BitMap constructor,
     // but we will just overwrite that with the contents of the
     // map found in the file
-    file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    numFileSectors = divRoundUp(numWords * sizeof(unsigned), SectorSize);
+    dirty = new Bitmap(numFileSectors);
+    FetchFrom(file);
 }
 
 //----------------------------------------------------------------------
@@ -50,6 +57,83 @@ PersistentBitmap::PersistentBitmap(OpenFile *file, int numItems) : Bitmap(numIte
 
 PersistentBitmap::~PersistentBitmap()
 {
+    delete dirty;
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::Mark, PersistentBitmap::Clear
+// 	Set or clear the "nth" bit, remembering which sector of the
+//	bitmap file now differs from the disk.
+//
+//	"which" is the number of the bit to be changed.
+//----------------------------------------------------------------------
+
+void PersistentBitmap::Mark(int which)
+{
+    if (!Test(which))
+    {
+        Bitmap::Mark(which);
+        dirty->Mark((which / BitsInWord) * sizeof(unsigned) / SectorSize);
+    }
+}
+
+void PersistentBitmap::Clear(int which)
+{
+    if (Test(which))
+    {
+        Bitmap::Clear(which);
+        dirty->Mark((which / BitsInWord) * sizeof(unsigned) / SectorSize);
+    }
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::FindAndSetNear
+// 	Allocate a free sector as close as possible to "sector": the
+//	first free one after it on the same track, else the first free
+//	one on that track, else on the nearest track that has any.
+//	Allocating each data block near the previous one keeps files
+//	on few tracks, and mostly in consecutive sectors.
+//
+//	Return -1 if the disk is full.
+//
+//	"sector" is where the caller would like the new sector to be
+//----------------------------------------------------------------------
+
+int PersistentBitmap::FindAndSetNear(int sector)
+{
+    int numTracks = divRoundUp(numBits, SectorsPerTrack);
+    int track = sector / SectorsPerTrack;
+    int result, t;
+
+    ASSERT(sector >= 0 && sector < numBits);
+    if (NumClearOnTrack(track) > 0)
+    {
+        result = FindAndSet(sector, (track + 1) * SectorsPerTrack);
+        if (result == -1)
+            result = FindAndSet(track * SectorsPerTrack, sector);
+        return result;
+    }
+    for (int distance = 1; distance < numTracks; distance++)
+    {
+        t = track + distance;
+        if (t < numTracks && NumClearOnTrack(t) > 0)
+            return FindAndSet(t * SectorsPerTrack, (t + 1) * SectorsPerTrack);
+        t = track - distance;
+        if (t >= 0 && NumClearOnTrack(t) > 0)
+            return FindAndSet(t * SectorsPerTrack, (t + 1) * SectorsPerTrack);
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::NumClearOnTrack
+// 	Return the number of free sectors on "track", from the per-group
+//	summary kept by Bitmap.
+//----------------------------------------------------------------------
+
+int PersistentBitmap::NumClearOnTrack(int track) const
+{
+    return NumClear(track * SectorsPerTrack, (track + 1) * SectorsPerTrack);
 }
 
 //----------------------------------------------------------------------
@@ -62,16 +146,36 @@ PersistentBitmap::~PersistentBitmap()
 void PersistentBitmap::FetchFrom(OpenFile *file)
 {
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    CountClear();
+    for (int i = 0; i < numFileSectors; i++)
+        dirty->Clear(i);
 }
 
 //----------------------------------------------------------------------
 // PersistentBitmap::WriteBack
 // 	Store the contents of a persistent bitmap to a Nachos file.
+//	Only the sectors with changed bits are written; each run of
+//	consecutive changed sectors goes out in one WriteAt.
 //
 //	"file" is the place to write the bitmap to
 //----------------------------------------------------------------------
 
 void PersistentBitmap::WriteBack(OpenFile *file)
 {
-    file->WriteAt((char *)map, numWords * sizeof(unsigned), 0);
+    int mapBytes = numWords * sizeof(unsigned);
+    int first, last;
+
+    for (first = 0; first < numFileSectors; first = last)
+    {
+        if (!dirty->Test(first))
+        {
+            last = first + 1;
+            continue;
+        }
+        for (last = first; last < numFileSectors && dirty->Test(last); last++)
+            dirty->Clear(last);
+        file->WriteAt((char *)map + first * SectorSize,
+                      min(last * SectorSize, mapBytes) - first * SectorSize,
+                      first * SectorSize);
+    }
 }
@@ -6,6 +6,13 @@
 //    when it is created, or it can be initialized later using
 //    the FetchFrom method
 //
+//    Only the sectors of the file holding bits changed since the
+//    bitmap was read are written back.
+//
+//    The bits stand for disk sectors, so allocation can be steered
+//    towards a track: FindAndSetNear looks on the track of a given
+//    sector first, then on the nearest tracks with free space.
+//
 // Copyright (c) 1992,1993,1995 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
@@ -16,6 +23,7 @@
 #include "copyright.h"
 #include "bitmap.h"
 #include "openfile.h"
+#include "disk.h"
 
 // The following class defines a persistent bitmap.  It inherits all
 // the behavior of a bitmap (see bitmap.h), adding the ability to
@@ -29,8 +37,21 @@ public:
 
     ~PersistentBitmap(); // deallocate bitmap
 
+    void Mark(int which);  // Set the "nth" bit
+    void Clear(int which); // Clear the "nth" bit
+
+    int FindAndSetNear(int sector); // Allocate a free sector, on the
+                                    // track of "sector" if possible
+    int NumClearOnTrack(int track) const; // Free sectors on a track
+
     void FetchFrom(OpenFile *file); // read bitmap from the disk
-    void WriteBack(OpenFile *file); // write bitmap contents to disk
+    void WriteBack(OpenFile *file); // write changed parts of the
+                                    // bitmap to disk
+
+private:
+    int numFileSectors; // size of the bitmap file, in sectors
+    Bitmap *dirty;      // sectors of the bitmap file changed
+                        // since it was read or written
 };
 
 #endif // PBITMAP_H
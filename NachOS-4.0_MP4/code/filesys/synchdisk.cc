@@ -5,10 +5,16 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Each request carries a semaphore to synchronize the interrupt
+//	handler with the thread waiting for it.  Because the physical disk
+//	can only handle one operation at a time, requests that arrive
+//	while it is busy are queued; when the current one completes, the
+//	interrupt handler chooses the next according to the scheduling
+//	policy (see synchdisk.h) and starts it.
+//
+//	Read-ahead requests have a queue of their own, and are only issued
+//	when no synchronous request is waiting.  The queues, "current" and
+//	the read-ahead buffers are only touched with interrupts disabled.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -16,19 +22,34 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "journal.h"
+#include "main.h"
 
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
 // 	Initialize the synchronous interface to the physical disk, in turn
 //	initializing the physical disk.
 //
+//	"policy" -- the order to serve queued requests in
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk()
+SynchDisk::SynchDisk(DiskSchedPolicy policy)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
+    this->policy = policy;
     disk = new Disk(this);
+    pending = pendingTail = cursor = NULL;
+    current = NULL;
+    headSector = 0; // where Disk starts its head
+    headUp = TRUE;
+    journal = NULL;
+    prefetchQueue = new List<int>;
+    for (int i = 0; i < PrefetchBuffers; i++)
+    {
+        buffers[i].sector = -1;
+        buffers[i].valid = FALSE;
+        buffers[i].used = FALSE;
+    }
+    nextVictim = 0;
 }
 
 //----------------------------------------------------------------------
@@ -40,14 +61,36 @@ SynchDisk::SynchDisk()
 SynchDisk::~SynchDisk()
 {
     delete disk;
-    delete lock;
-    delete semaphore;
+    delete prefetchQueue;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ParsePolicy
+// 	Return the scheduling policy called "name" (as given with -ds on
+//	the command line).
+//----------------------------------------------------------------------
+
+DiskSchedPolicy
+SynchDisk::ParsePolicy(char *name)
+{
+    if (strcmp(name, "fifo") == 0)
+        return DiskFIFO;
+    if (strcmp(name, "sstf") == 0)
+        return DiskSSTF;
+    if (strcmp(name, "scan") == 0)
+        return DiskSCAN;
+    if (strcmp(name, "clook") == 0)
+        return DiskCLOOK;
+    cerr << "Unknown disk scheduling policy " << name << "\n";
+    ASSERTNOTREACHED();
+    return DiskFIFO;
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::ReadSector
 // 	Read the contents of a disk sector into a buffer.  Return only
-//	after the data has been read.
+//	after the data has been read.  A copy of the sector waiting in
+//	the metadata log is newer than the one on disk.
 //
 //	"sectorNumber" -- the disk sector to read
 //	"data" -- the buffer to hold the contents of the disk sector
@@ -55,16 +98,42 @@ SynchDisk::~SynchDisk()
 
 void SynchDisk::ReadSector(int sectorNumber, char *data)
 {
-    lock->Acquire(); // only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P(); // wait for interrupt
-    lock->Release();
+    PrefetchBuffer *buf;
+    DiskRequest req;
+    IntStatus oldLevel;
+
+    if (journal != NULL && journal->Lookup(sectorNumber, data))
+        return;
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    buf = FindBuffer(sectorNumber);
+    if (buf != NULL && buf->valid)
+    {
+        DEBUG(dbgDisk, "Read-ahead hit on sector " << sectorNumber);
+        bcopy(buf->data, data, SectorSize);
+        buf->used = TRUE;
+        kernel->stats->numPrefetchHits++;
+    }
+    else
+    {
+        if (prefetchQueue->IsInList(sectorNumber))
+            prefetchQueue->Remove(sectorNumber);
+        req.sector = sectorNumber;
+        req.data = data;
+        req.writing = FALSE;
+        Request(&req, 1);
+    }
+    (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::WriteSector
 // 	Write the contents of a buffer into a disk sector.  Return only
-//	after the data has been written.
+//	after the data has been written.  A read-ahead copy of the sector
+//	is updated as well, so it never goes stale; one still on its way
+//	from the disk is dropped.
+//
+//	Writes made by a file system operation are held back by the
+//	metadata log instead, until their transaction is committed.
 //
 //	"sectorNumber" -- the disk sector to be written
 //	"data" -- the new contents of the disk sector
@@ -72,19 +141,454 @@ void SynchDisk::ReadSector(int sectorNumber, char *data)
 
 void SynchDisk::WriteSector(int sectorNumber, char *data)
 {
-    lock->Acquire(); // only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P(); // wait for interrupt
-    lock->Release();
+    PrefetchBuffer *buf;
+    DiskRequest req;
+    IntStatus oldLevel;
+
+    if (journal != NULL && journal->Absorb(sectorNumber, data))
+        return;
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    buf = FindBuffer(sectorNumber);
+    if (buf != NULL && buf->valid)
+        bcopy(data, buf->data, SectorSize);
+    else if (buf != NULL)
+        buf->sector = -1;
+    req.sector = sectorNumber;
+    req.data = data;
+    req.writing = TRUE;
+    Request(&req, 1);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	Read "count" sectors into consecutive sector-sized parts of a
+//	buffer, returning only after all of them have been read.  Sectors
+//	found in the metadata log or the read-ahead buffers are copied
+//	from memory; the others are queued together, so that the
+//	interrupt handler can start each one the moment the previous one
+//	is done.  For consecutive sectors on a track, the disk then never
+//	has to wait for one to come round again.
+//
+//	"sectorNumbers" -- the disk sectors to read
+//	"data" -- the buffer to hold their contents, in the same order
+//	"count" -- the number of sectors
+//----------------------------------------------------------------------
+
+void SynchDisk::ReadSectors(int *sectorNumbers, char *data, int count)
+{
+    DiskRequest *reqs = new DiskRequest[count];
+    PrefetchBuffer *buf;
+    IntStatus oldLevel;
+    int queued = 0;
+
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    for (int i = 0; i < count; i++)
+    {
+        if (journal != NULL &&
+            journal->Lookup(sectorNumbers[i], data + i * SectorSize))
+            continue;
+        buf = FindBuffer(sectorNumbers[i]);
+        if (buf != NULL && buf->valid)
+        {
+            bcopy(buf->data, data + i * SectorSize, SectorSize);
+            buf->used = TRUE;
+            kernel->stats->numPrefetchHits++;
+            continue;
+        }
+        if (prefetchQueue->IsInList(sectorNumbers[i]))
+            prefetchQueue->Remove(sectorNumbers[i]);
+        reqs[queued].sector = sectorNumbers[i];
+        reqs[queued].data = data + i * SectorSize;
+        reqs[queued].writing = FALSE;
+        queued++;
+    }
+    Request(reqs, queued);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    delete[] reqs;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write "count" sectors from consecutive sector-sized parts of a
+//	buffer, returning only after all of them have been written.  As
+//	with ReadSectors, the writes are queued together; as with
+//	WriteSector, the metadata log and read-ahead buffers see each one
+//	first.
+//
+//	"sectorNumbers" -- the disk sectors to write
+//	"data" -- their new contents, in the same order
+//	"count" -- the number of sectors
+//----------------------------------------------------------------------
+
+void SynchDisk::WriteSectors(int *sectorNumbers, char *data, int count)
+{
+    DiskRequest *reqs = new DiskRequest[count];
+    PrefetchBuffer *buf;
+    IntStatus oldLevel;
+    int queued = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (journal != NULL &&
+            journal->Absorb(sectorNumbers[i], data + i * SectorSize))
+            continue;
+        reqs[queued].sector = sectorNumbers[i];
+        reqs[queued].data = data + i * SectorSize;
+        reqs[queued].writing = TRUE;
+        queued++;
+    }
+
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    for (int i = 0; i < queued; i++)
+    {
+        buf = FindBuffer(reqs[i].sector);
+        if (buf != NULL && buf->valid)
+            bcopy(reqs[i].data, buf->data, SectorSize);
+        else if (buf != NULL)
+            buf->sector = -1;
+    }
+    Request(reqs, queued);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    delete[] reqs;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Prefetch
+// 	Queue a sector to be read ahead of time, and return immediately.
+//	The read is sent to the disk as soon as it is idle; nothing is
+//	done if the sector is already buffered or queued.
+//
+//	"sectorNumber" -- the disk sector to read ahead
+//----------------------------------------------------------------------
+
+void SynchDisk::Prefetch(int sectorNumber)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    if (FindBuffer(sectorNumber) == NULL &&
+        !prefetchQueue->IsInList(sectorNumber) &&
+        prefetchQueue->NumInList() < PrefetchBuffers)
+        prefetchQueue->Append(sectorNumber);
+    StartNext();
+    (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::CallBack
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Wake up the thread waiting for the disk
+//	request to finish (or mark the read-ahead buffer valid), then
+//	start the next request.
 //----------------------------------------------------------------------
 
 void SynchDisk::CallBack()
 {
-    semaphore->V();
+    DiskRequest *req = current;
+
+    ASSERT(req != NULL);
+    current = NULL;
+    if (req->done != NULL)
+        Finish(req);
+    else
+        req->buf->valid = TRUE;
+    StartNext();
+}
+
+//----------------------------------------------------------------------
+// CompareRequests
+// 	Order two queued requests of a batch by sector, and requests for
+//	the same sector in the order they were made (they are in one
+//	array).  For qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareRequests(const void *a, const void *b)
+{
+    DiskRequest *x = *(DiskRequest **)a;
+    DiskRequest *y = *(DiskRequest **)b;
+
+    if (x->sector != y->sector)
+        return (x->sector < y->sector) ? -1 : 1;
+    return (x < y) ? -1 : (x > y);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Request
+// 	Queue "count" synchronous requests, and wait until the interrupt
+//	handler reports all of them done.  If the disk is idle the first
+//	one to be served starts at once.
+//
+//	Assumes interrupts are disabled.
+//----------------------------------------------------------------------
+
+void SynchDisk::Request(DiskRequest *reqs, int count)
+{
+    Semaphore done("disk request", 0);
+    DiskRequest **sorted;
+    int left = count;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    if (count == 0)
+        return;
+    sorted = new DiskRequest *[count];
+    for (int i = 0; i < count; i++)
+    {
+        reqs[i].done = &done;
+        reqs[i].left = &left;
+        reqs[i].buf = NULL;
+        sorted[i] = &reqs[i];
+    }
+    if (policy != DiskFIFO)
+        qsort(sorted, count, sizeof(DiskRequest *), CompareRequests);
+    Enqueue(sorted, count);
+    delete[] sorted;
+    StartNext();
+    done.P(); // wait for interrupt
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Enqueue
+// 	Add "count" requests to the pending queue.  For FIFO they go at
+//	the end.  Otherwise they come sorted by sector, and are merged
+//	into the queue in one pass, each after any request already
+//	waiting for the same sector; a batch above everything queued
+//	(such as a track being read in order) is simply appended.
+//
+//	"reqs" -- the requests, sorted unless the policy is FIFO
+//	"count" -- how many
+//----------------------------------------------------------------------
+
+void SynchDisk::Enqueue(DiskRequest **reqs, int count)
+{
+    DiskRequest *pos = pending; // insert before this, NULL for the end
+    DiskRequest *req;
+
+    for (int i = 0; i < count; i++)
+    {
+        req = reqs[i];
+        if (policy == DiskFIFO ||
+            (pendingTail != NULL && pendingTail->sector <= req->sector))
+            pos = NULL;
+        while (pos != NULL && pos->sector <= req->sector)
+            pos = pos->next;
+
+        req->next = pos;
+        req->prev = (pos == NULL) ? pendingTail : pos->prev;
+        if (req->prev == NULL)
+            pending = req;
+        else
+            req->prev->next = req;
+        if (pos == NULL)
+            pendingTail = req;
+        else
+            pos->prev = req;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Finish
+// 	Called when a synchronous request completes.  Wake up the thread
+//	waiting for it once every request of its batch is done, so that a
+//	large batch costs one wakeup rather than one per sector.
+//----------------------------------------------------------------------
+
+void SynchDisk::Finish(DiskRequest *req)
+{
+    if (--*req->left == 0)
+        req->done->V();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	If the disk is idle, send it the next pending request, or a
+//	read-ahead if nothing else is waiting.
+//
+//	A pending read may have been buffered by a read-ahead since it
+//	was queued; it is completed from memory right here.
+//
+//	Assumes interrupts are disabled.
+//----------------------------------------------------------------------
+
+void SynchDisk::StartNext()
+{
+    DiskRequest *req;
+    PrefetchBuffer *buf;
+
+    while (current == NULL)
+    {
+        if (pending == NULL)
+        {
+            StartPrefetch();
+            return;
+        }
+        req = NextRequest();
+        buf = FindBuffer(req->sector);
+        if (!req->writing && buf != NULL && buf->valid)
+        {
+            DEBUG(dbgDisk, "Read-ahead hit on sector " << req->sector);
+            bcopy(buf->data, req->data, SectorSize);
+            buf->used = TRUE;
+            kernel->stats->numPrefetchHits++;
+            Finish(req);
+            continue;
+        }
+
+        current = req;
+        headSector = req->sector;
+        if (req->writing)
+            disk->WriteRequest(req->sector, req->data);
+        else
+            disk->ReadRequest(req->sector, req->data);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::NextRequest
+// 	Remove and return the pending request to serve next, according to
+//	the scheduling policy.  Distance is measured in sectors from
+//	"headSector", which orders requests by track first and then by
+//	position within the track.
+//
+//	Except for FIFO the queue is sorted by sector, so the candidates
+//	are the first request at or above the head and the last one
+//	below it, found from "cursor".  The cursor is left on the request
+//	after the one chosen, which is where the next search starts, so
+//	a sweep over a batch costs constant time per request.
+//
+//	Assumes "pending" is not empty.
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::NextRequest()
+{
+    DiskRequest *best = pending;  // FIFO: oldest first
+    DiskRequest *ahead = NULL;    // first at or above the head
+    DiskRequest *behind = NULL;   // closest below the head
+
+    if (policy != DiskFIFO)
+    {
+        ahead = FirstAtOrAbove(headSector);
+        behind = (ahead != NULL) ? ahead->prev : pendingTail;
+        // the oldest request for that sector goes first
+        while (behind != NULL && behind->prev != NULL &&
+               behind->prev->sector == behind->sector)
+            behind = behind->prev;
+    }
+
+    switch (policy)
+    {
+    case DiskFIFO:
+        break;
+    case DiskSSTF:
+        best = ahead;
+        if (behind != NULL && (ahead == NULL ||
+                               headSector - behind->sector <
+                                   ahead->sector - headSector))
+            best = behind;
+        break;
+    case DiskSCAN:
+        if (!headUp && ahead != NULL && ahead->sector == headSector)
+            best = ahead; // no distance at all
+        else
+            best = headUp ? ahead : behind;
+        if (best == NULL)
+        {
+            headUp = !headUp; // nothing left ahead, turn around
+            best = headUp ? ahead : behind;
+        }
+        break;
+    case DiskCLOOK:
+        best = (ahead != NULL) ? ahead : pending; // else wrap around
+        break;
+    default:
+        ASSERTNOTREACHED();
+    }
+
+    if (best->prev == NULL)
+        pending = best->next;
+    else
+        best->prev->next = best->next;
+    if (best->next == NULL)
+        pendingTail = best->prev;
+    else
+        best->next->prev = best->prev;
+    cursor = best->next;
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::FirstAtOrAbove
+// 	Return the first request in the (sorted) pending queue for
+//	"sector" or a higher one, or NULL if there is none.  The search
+//	starts at "cursor" and walks back or forward from there, which
+//	is only a step or two when the head has moved on by one request.
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::FirstAtOrAbove(int sector)
+{
+    DiskRequest *req = (cursor != NULL) ? cursor : pendingTail;
+
+    while (req != NULL && req->prev != NULL && req->prev->sector >= sector)
+        req = req->prev;
+    while (req != NULL && req->sector < sector)
+        req = req->next;
+    return req;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartPrefetch
+// 	Send the next queued sector to read ahead to the (idle) disk.
+//	The oldest buffer is reused for the data; if it was never read,
+//	the earlier prefetch was wasted.
+//
+//	Assumes interrupts are disabled.
+//----------------------------------------------------------------------
+
+void SynchDisk::StartPrefetch()
+{
+    PrefetchBuffer *buf;
+    int sector;
+
+    ASSERT(current == NULL);
+    while (!prefetchQueue->IsEmpty())
+    {
+        sector = prefetchQueue->RemoveFront();
+        if (FindBuffer(sector) != NULL)
+            continue; // already buffered
+
+        buf = &buffers[nextVictim];
+        nextVictim = (nextVictim + 1) % PrefetchBuffers;
+        if (buf->sector != -1 && !buf->used)
+            kernel->stats->numPrefetchWasted++;
+        buf->sector = sector;
+        buf->valid = FALSE;
+        buf->used = FALSE;
+
+        DEBUG(dbgDisk, "Reading ahead sector " << sector);
+        readAhead.sector = sector;
+        readAhead.data = buf->data;
+        readAhead.writing = FALSE;
+        readAhead.done = NULL;
+        readAhead.buf = buf;
+        current = &readAhead;
+        headSector = sector;
+        kernel->stats->numPrefetchReads++;
+        disk->ReadRequest(sector, buf->data);
+        return;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::FindBuffer
+// 	Return the read-ahead buffer holding "sectorNumber" (whether or
+//	not its data has arrived yet), or NULL if there is none.
+//----------------------------------------------------------------------
+
+PrefetchBuffer *SynchDisk::FindBuffer(int sectorNumber)
+{
+    for (int i = 0; i < PrefetchBuffers; i++)
+        if (buffers[i].sector == sectorNumber)
+            return &buffers[i];
+    return NULL;
 }
@@ -14,6 +14,59 @@
 #include "disk.h"
 #include "synch.h"
 #include "callback.h"
+#include "list.h"
+
+class Journal;
+
+#define PrefetchBuffers 32 // sectors kept in memory by read-ahead
+
+// The following class defines a buffer holding one sector read ahead
+// of time.  "valid" is FALSE while the disk is still filling it in.
+
+class PrefetchBuffer
+{
+public:
+    int sector;             // sector held, -1 if the buffer is free
+    bool valid;             // has the data arrived from the disk?
+    bool used;              // was the data ever handed to a reader?
+    char data[SectorSize];  // contents of "sector"
+};
+
+// Orders in which queued disk requests can be served.  "headSector" is
+// the sector most recently sent to the disk.
+//
+//	DiskFIFO  -- arrival order
+//	DiskSSTF  -- closest sector to the head first
+//	DiskSCAN  -- elevator: keep moving in one direction while there are
+//		     requests ahead of the head, then turn around
+//	DiskCLOOK -- sweep upwards only; after the highest request, jump
+//		     back to the lowest one
+
+enum DiskSchedPolicy
+{
+    DiskFIFO,
+    DiskSSTF,
+    DiskSCAN,
+    DiskCLOOK
+};
+
+// The following class defines a request waiting for the disk.  "done"
+// is signalled by the interrupt handler when the last request of its
+// batch completes; it is NULL for read-ahead requests, whose data goes
+// into "buf".
+
+class DiskRequest
+{
+public:
+    int sector;           // sector to read or write
+    char *data;           // where the data comes from or goes
+    bool writing;         // is this a write request?
+    Semaphore *done;      // wakes up the requesting thread
+    int *left;            // requests of the batch not done yet
+    DiskRequest *next;    // next request in the pending queue
+    DiskRequest *prev;    // previous one
+    PrefetchBuffer *buf;  // buffer being filled by a read-ahead
+};
 
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
@@ -25,11 +78,25 @@
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// Requests from different threads are not serialized with a lock:
+// each one is queued, and whenever the disk becomes free the interrupt
+// handler picks the next request according to the scheduling policy,
+// starts it, and wakes up the thread whose request just finished.
+// ReadSectors and WriteSectors queue a whole batch of requests from
+// one thread the same way.
+//
+// Sectors can also be read ahead of time with Prefetch: the request is
+// queued and sent to the disk whenever it is idle, and the data is kept
+// in a small set of buffers when the interrupt arrives.  A later
+// ReadSector of that sector is then satisfied from memory.  Synchronous
+// requests always go before queued prefetches.
 
 class SynchDisk : public CallBackObj
 {
 public:
-    SynchDisk();  // Initialize a synchronous disk,
+    SynchDisk(DiskSchedPolicy policy = DiskCLOOK);
+                  // Initialize a synchronous disk,
                   // by initializing the raw Disk.
     ~SynchDisk(); // De-allocate the synch disk data
 
@@ -41,16 +108,73 @@ public:
     // then wait until the request is done.
     void WriteSector(int sectorNumber, char *data);
 
+    void ReadSectors(int *sectorNumbers, char *data, int count);
+    // Read/write "count" sectors, into or
+    // from consecutive sector-sized parts
+    // of "data".  All of the requests are
+    // queued at once, so the disk goes
+    // from one to the next without waiting
+    // for this thread.
+    void WriteSectors(int *sectorNumbers, char *data, int count);
+
+    void Prefetch(int sectorNumber);
+    // Read a disk sector in the background,
+    // returning immediately.
+
     void CallBack(); // Called by the disk device interrupt
                      // handler, to signal that the
                      // current disk operation is complete.
 
+    void SetJournal(Journal *log) { journal = log; }
+    // Send reads and writes through
+    // the metadata log first
+
+    static DiskSchedPolicy ParsePolicy(char *name);
+    // Map "fifo", "sstf", "scan" or
+    // "clook" to a policy
+
 private:
-    Disk *disk;           // Raw disk device
-    Semaphore *semaphore; // To synchronize requesting thread
-                          // with the interrupt handler
-    Lock *lock;           // Only one read/write request
-                          // can be sent to the disk at a time
+    Disk *disk;                // Raw disk device
+    DiskSchedPolicy policy;    // Order to serve queued requests in
+    DiskRequest *pending;      // Synchronous requests not yet sent
+                               // to the disk, linked through "next"
+                               // and "prev": in arrival order for
+                               // FIFO, else by sector (arrival order
+                               // among requests for one sector)
+    DiskRequest *pendingTail;  // Last request in "pending"
+    DiskRequest *cursor;       // Where the search for the request
+                               // at the head starts, NULL for the
+                               // tail; a hint, not always exact
+    DiskRequest *current;      // Request being served by the disk,
+                               // NULL if the disk is idle
+    int headSector;            // Last sector sent to the disk
+    bool headUp;               // SCAN: is the head moving towards
+                               // higher sectors?
+    Journal *journal;          // Metadata log, NULL if none
+
+    List<int> *prefetchQueue;  // Sectors to read ahead
+    PrefetchBuffer buffers[PrefetchBuffers];
+    int nextVictim;            // Next buffer to reuse, round robin
+    DiskRequest readAhead;     // The read-ahead request, when it is
+                               // the one being served
+
+    void Request(DiskRequest *reqs, int count);
+                               // Queue requests and wait for all
+                               // of them
+    void StartNext();          // Send the next request to the disk,
+                               // if it is idle
+    void Enqueue(DiskRequest **reqs, int count);
+                               // Add requests, sorted by sector,
+                               // to "pending"
+    DiskRequest *FirstAtOrAbove(int sector);
+                               // First pending request for "sector"
+                               // or a higher one
+    DiskRequest *NextRequest(); // Remove the next request to serve
+                               // from "pending"
+    void StartPrefetch();      // Send the next queued read-ahead
+    void Finish(DiskRequest *req); // Wake up the requesting thread,
+                               // if its batch is complete
+    PrefetchBuffer *FindBuffer(int sectorNumber);
 };
 
 #endif // SYNCHDISK_H
@@ -31,6 +31,11 @@ Bitmap::Bitmap(int numItems)
     {
         map[i] = 0; // initialize map to keep Purify happy
     }
+    numGroups = divRoundUp(numWords, WordsInGroup);
+    for (numLeaves = 1; numLeaves < numGroups; numLeaves *= 2)
+        ;
+    summary = new int[2 * numLeaves];
+    CountClear();
     for (i = 0; i < numBits; i++)
     {
         Clear(i);
@@ -45,6 +50,7 @@ Bitmap::Bitmap(int numItems)
 Bitmap::~Bitmap()
 {
     delete[] map;
+    delete[] summary;
 }
 
 //----------------------------------------------------------------------
@@ -58,7 +64,12 @@ void Bitmap::Mark(int which)
 {
     ASSERT(which >= 0 && which < numBits);
 
-    map[which / BitsInWord] |= 1 << (which % BitsInWord);
+    if (!Test(which))
+    {
+        map[which / BitsInWord] |= 1 << (which % BitsInWord);
+        numClear--;
+        AddToGroup(which / BitsInGroup, -1);
+    }
 
     ASSERT(Test(which));
 }
@@ -74,7 +85,12 @@ void Bitmap::Clear(int which)
 {
     ASSERT(which >= 0 && which < numBits);
 
-    map[which / BitsInWord] &= ~(1 << (which % BitsInWord));
+    if (Test(which))
+    {
+        map[which / BitsInWord] &= ~(1 << (which % BitsInWord));
+        numClear++;
+        AddToGroup(which / BitsInGroup, 1);
+    }
 
     ASSERT(!Test(which));
 }
@@ -111,37 +127,190 @@ bool Bitmap::Test(int which) const
 
 int Bitmap::FindAndSet()
 {
-    for (int i = 0; i < numBits; i++)
+    return FindAndSet(0, numBits);
+}
+
+//----------------------------------------------------------------------
+// Bitmap::FindAndSet
+// 	Return the number of the first clear bit between "from" and
+//	"to" - 1, and set it.  A run of full groups is stepped over in
+//	one walk of the summary tree, and full words one at a time.
+//
+//	If no bits in the range are clear, return -1.
+//----------------------------------------------------------------------
+
+int Bitmap::FindAndSet(int from, int to)
+{
+    int i = max(from, 0);
+    int group;
+
+    to = min(to, numBits);
+    while (i < to)
     {
-        if (!Test(i))
+        if (GroupClear(i / BitsInGroup) == 0)
+        {
+            group = NextGroupWithClear(i / BitsInGroup + 1);
+            if (group == -1)
+                return -1;
+            i = group * BitsInGroup;
+        }
+        else if (map[i / BitsInWord] == ~0u)
+        {
+            i = (i / BitsInWord + 1) * BitsInWord;
+        }
+        else if (!Test(i))
         {
             Mark(i);
             return i;
         }
+        else
+        {
+            i++;
+        }
     }
     return -1;
 }
 
 //----------------------------------------------------------------------
 // Bitmap::NumClear
-// 	Return the number of clear bits in the bitmap.
-//	(In other words, how many bits are unallocated?)
+// 	Return the number of clear bits between "from" and "to" - 1.
+//	Groups lying entirely in the range are counted from the summary
+//	tree; only the bits of the groups at either end are tested.
 //----------------------------------------------------------------------
 
-int Bitmap::NumClear() const
+int Bitmap::NumClear(int from, int to) const
 {
     int count = 0;
+    int i = max(from, 0);
+    int firstWhole, lastWhole;
 
-    for (int i = 0; i < numBits; i++)
+    to = min(to, numBits);
+    if (i >= to)
+        return 0;
+    firstWhole = divRoundUp(i, BitsInGroup);
+    lastWhole = (to == numBits) ? numGroups : to / BitsInGroup;
+    if (firstWhole >= lastWhole)
+    {
+        firstWhole = lastWhole = to; // no whole group in the range
+    }
+    else
+    {
+        count = NumClearInGroups(firstWhole, lastWhole);
+        firstWhole *= BitsInGroup;
+        lastWhole = min(lastWhole * BitsInGroup, numBits);
+    }
+    for (; i < firstWhole; i++)
     {
         if (!Test(i))
-        {
             count++;
+    }
+    for (i = lastWhole; i < to; i++)
+    {
+        if (!Test(i))
+            count++;
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::AddToGroup
+// 	Add "count" to the number of clear bits in "group", and to every
+//	sum above it in the summary tree.
+//----------------------------------------------------------------------
+
+void Bitmap::AddToGroup(int group, int count)
+{
+    for (int node = numLeaves + group; node >= 1; node /= 2)
+        summary[node] += count;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NextGroupWithClear
+// 	Return the first group, from "group" on, with a clear bit, or -1
+//	if there is none.  Climb the summary tree until a subtree to the
+//	right has a clear bit, then go down to its leftmost such leaf.
+//----------------------------------------------------------------------
+
+int Bitmap::NextGroupWithClear(int group) const
+{
+    int node = numLeaves + group;
+
+    if (group >= numGroups)
+        return -1;
+    while (summary[node] == 0)
+    {
+        // step to the next subtree at this level, climbing while
+        // "node" is a right child (or the root)
+        while (node % 2 == 1)
+        {
+            if (node == 1)
+                return -1; // nothing to the right of the start
+            node /= 2;
         }
+        node++;
+    }
+    while (node < numLeaves)
+        node = (summary[2 * node] > 0) ? 2 * node : 2 * node + 1;
+    return node - numLeaves;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NumClearInGroups
+// 	Return the number of clear bits in groups "from" up to "to" - 1,
+//	adding up the fewest subtrees of the summary that cover them.
+//----------------------------------------------------------------------
+
+int Bitmap::NumClearInGroups(int from, int to) const
+{
+    int count = 0;
+    int lo = numLeaves + from;
+    int hi = numLeaves + to; // one past the last leaf
+
+    while (lo < hi)
+    {
+        if (lo % 2 == 1)
+            count += summary[lo++];
+        if (hi % 2 == 1)
+            count += summary[--hi];
+        lo /= 2;
+        hi /= 2;
     }
     return count;
 }
 
+//----------------------------------------------------------------------
+// Bitmap::CountClear
+// 	Recompute the number of clear bits, overall and in each group
+//	and subtree of the summary, from scratch.  Needed only when "map" was filled in directly (for
+//	instance, read from disk); otherwise Mark and Clear keep the
+//	counts current, so NumClear does not have to scan the bitmap.
+//----------------------------------------------------------------------
+
+void Bitmap::CountClear()
+{
+    unsigned int word;
+    int i;
+
+    for (i = 0; i < numLeaves; i++)
+    {
+        summary[numLeaves + i] = max(0, min(BitsInGroup,
+                                            numBits - i * BitsInGroup));
+    }
+    numClear = numBits;
+    for (i = 0; i < numWords; i++)
+    {
+        for (word = map[i]; word != 0; word &= word - 1)
+        {
+            numClear--; // one per set bit, lowest first
+            summary[numLeaves + i / WordsInGroup]--;
+        }
+    }
+    for (i = numLeaves - 1; i >= 1; i--)
+    {
+        summary[i] = summary[2 * i] + summary[2 * i + 1];
+    }
+}
+
 //----------------------------------------------------------------------
 // Bitmap::Print
 // 	Print the contents of the bitmap, for debugging.
@@ -21,6 +21,8 @@
 // Definitions helpful for representing a bitmap as an array of integers
 const int BitsInByte = 8;
 const int BitsInWord = sizeof(unsigned int) * BitsInByte;
+const int WordsInGroup = 32; // words summarized by one free count
+const int BitsInGroup = BitsInWord * WordsInGroup;
 
 // The following class defines a "bitmap" -- an array of bits,
 // each of which can be independently set, cleared, and tested.
@@ -29,21 +31,34 @@ const int BitsInWord = sizeof(unsigned int) * BitsInByte;
 // for instance, disk sectors, or main memory pages.
 // Each bit represents whether the corresponding sector or page is
 // in use or free.
+//
+// To find clear bits quickly in a large bitmap, the number of clear
+// bits in each group of WordsInGroup words is kept as well, at the
+// leaves of a binary tree whose inner nodes hold the sum of their
+// children.  The first group with a clear bit after a given one, and
+// the number of clear bits in a range of groups, are found by walking
+// the tree, in time logarithmic in the number of groups.  Inside a
+// group, searches skip full words before looking at single bits.
 
 class Bitmap
 {
 public:
     Bitmap(int numItems); // Initialize a bitmap, with "numItems" bits
                           // initially, all bits are cleared.
-    ~Bitmap();            // De-allocate bitmap
+    virtual ~Bitmap();    // De-allocate bitmap
 
-    void Mark(int which);       // Set the "nth" bit
-    void Clear(int which);      // Clear the "nth" bit
+    virtual void Mark(int which);  // Set the "nth" bit
+    virtual void Clear(int which); // Clear the "nth" bit
     bool Test(int which) const; // Is the "nth" bit set?
     int FindAndSet();           // Return the # of a clear bit, and as a side
         // effect, set the bit.
         // If no bits are clear, return -1.
-    int NumClear() const; // Return the number of clear bits
+    int FindAndSet(int from, int to); // Same, looking only at bits
+                                      // "from" up to "to" - 1
+    int NumClear() const { return numClear; }
+    // Return the number of clear bits
+    int NumClear(int from, int to) const; // ... among bits "from"
+                                          // up to "to" - 1
 
     void Print() const; // Print contents of bitmap
     void SelfTest();    // Test whether bitmap is working
@@ -55,6 +70,25 @@ protected:
                        //  multiple of the number of bits in
                        //  a word)
     unsigned int *map; // bit storage
+    int numClear;      // number of clear bits, kept up to
+                       // date by Mark and Clear
+    int numGroups;     // number of groups of words
+    int numLeaves;     // numGroups, rounded up to a power of 2
+    int *summary;      // clear bits per group, in a tree: node
+                       // n has children 2n and 2n+1, group g
+                       // is node numLeaves + g, 1 is the root
+
+    void CountClear(); // Recompute "numClear" and "summary",
+                       // after "map" has been overwritten
+    void AddToGroup(int group, int count); // Change a group's clear
+                                           // count, and its sums
+    int NextGroupWithClear(int group) const; // First group from
+                                             // "group" on with a
+                                             // clear bit, or -1
+    int GroupClear(int group) const { return summary[numLeaves + group]; }
+    int NumClearInGroups(int from, int to) const; // Clear bits in
+                                                  // groups "from" up
+                                                  // to "to" - 1
 };
 
 #endif // BITMAP_H
@@ -32,6 +32,9 @@
 #include <sys/file.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 #include <cerrno>
 
 #ifdef SOLARIS
@@ -367,6 +370,90 @@ WriteFile(int fd, char *buffer, int nBytes)
     ASSERT(retVal == nBytes);
 }
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first "length" bytes of an open file into memory, shared
+//	with the file, so that stores to the memory change the file.
+//	A file shorter than "length" is first extended with zeros, since
+//	touching a mapped page past the end of the file kills the process.
+//	Return NULL if the file can't be extended or mapped.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int length)
+{
+    struct stat info;
+    void *addr;
+
+    if (fstat(fd, &info) != 0)
+        return NULL;
+    if (info.st_size < length && ftruncate(fd, length) != 0)
+        return NULL;
+    addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (addr == MAP_FAILED)
+        return NULL;
+    return (char *)addr;
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo MapFile.  The changes made through the memory stay in the
+//	file.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int length)
+{
+    int retVal = munmap(addr, length);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// SyncFile
+// 	Wait until "length" bytes of a mapped file, starting at "addr",
+//	have been written to the host disk.  Abort on error.
+//----------------------------------------------------------------------
+
+void
+SyncFile(char *addr, int length)
+{
+    long pageSize = getpagesize();
+    char *start = (char *)((unsigned long)addr & ~(pageSize - 1));
+    int retVal = msync(start, length + (addr - start), MS_SYNC);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// StartHostThread
+// 	Run "func(arg)" in a new host thread; return a handle to wait for
+//	it with JoinHostThread.  Abort if the thread can't be created.
+//----------------------------------------------------------------------
+
+void *
+StartHostThread(void *(*func)(void *), void *arg)
+{
+    pthread_t *thread = new pthread_t;
+    int retVal = pthread_create(thread, NULL, func, arg);
+
+    ASSERT(retVal == 0);
+    return (void *)thread;
+}
+
+//----------------------------------------------------------------------
+// JoinHostThread
+// 	Wait for a host thread started by StartHostThread to finish.
+//----------------------------------------------------------------------
+
+void
+JoinHostThread(void *thread)
+{
+    int retVal = pthread_join(*(pthread_t *)thread, NULL);
+
+    ASSERT(retVal == 0);
+    delete (pthread_t *)thread;
+}
+
 //----------------------------------------------------------------------
 // Lseek
 // 	Change the location within an open file.  Abort on error.
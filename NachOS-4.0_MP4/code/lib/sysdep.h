@@ -53,6 +53,20 @@ extern int Tell(int fd);
 extern int Close(int fd);
 extern bool Unlink(char *name);
 
+// Map an open file into memory, so that it can be read and written
+// without a system call per access.  MapFile returns NULL if the file
+// can't be mapped.
+extern char *MapFile(int fd, int length);
+extern void UnmapFile(char *addr, int length);
+extern void SyncFile(char *addr, int length); // flush part of a mapped
+                                              // file to the host disk
+
+// Host threads, for work done outside of the simulation that doesn't
+// touch any Nachos state (see filesys/fsck.cc).  These run truly in
+// parallel, unlike Nachos threads.
+extern void *StartHostThread(void *(*func)(void *), void *arg);
+extern void JoinHostThread(void *thread);
+
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
 extern "C" {
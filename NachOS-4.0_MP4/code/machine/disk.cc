@@ -27,11 +27,32 @@ const int MagicNumber = 0x456789ab;
 const int MagicSize = sizeof(int);
 const int DiskSize = (MagicSize + (NumSectors * SectorSize));
 
+//----------------------------------------------------------------------
+// ParseSyncPolicy
+// 	Return the sync policy called "name" (as given with -dsync on the
+//	command line), or DiskSyncNone if there is no name.
+//----------------------------------------------------------------------
+
+static DiskSyncPolicy
+ParseSyncPolicy(char *name)
+{
+    if (name == NULL || strcmp(name, "none") == 0)
+        return DiskSyncNone;
+    if (strcmp(name, "halt") == 0)
+        return DiskSyncHalt;
+    if (strcmp(name, "write") == 0)
+        return DiskSyncWrite;
+    cerr << "Unknown disk sync policy " << name << "\n";
+    ASSERTNOTREACHED();
+    return DiskSyncNone;
+}
+
 //----------------------------------------------------------------------
 // Disk::Disk()
 // 	Initialize a simulated disk.  Open the UNIX file (creating it
 //	if it doesn't exist), and check the magic number to make sure it's
-// 	ok to treat it as Nachos disk storage.
+// 	ok to treat it as Nachos disk storage.  Then map the file into
+//	memory; if that fails, requests read and write the file instead.
 //
 //	"toCall" -- object to call when disk read/write request completes
 //----------------------------------------------------------------------
@@ -63,17 +84,29 @@ Disk::Disk(CallBackObj *toCall)
         Lseek(fileno, DiskSize - sizeof(int), 0);
         WriteFile(fileno, (char *)&tmp, sizeof(int));
     }
+    image = MapFile(fileno, DiskSize);
+    if (image == NULL)
+    {
+        DEBUG(dbgDisk, "Can't map the disk, using read/write instead.");
+    }
+    syncPolicy = ParseSyncPolicy(kernel->diskSync);
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+//	disk, flushing it first if the sync policy says so.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    if (image != NULL)
+    {
+        if (syncPolicy == DiskSyncHalt)
+            SyncFile(image, DiskSize);
+        UnmapFile(image, DiskSize);
+    }
     Close(fileno);
 }
 
@@ -116,13 +149,22 @@ PrintSector(bool writing, int sector, char *data)
 void Disk::ReadRequest(int sectorNumber, char *data)
 {
     int ticks = ComputeLatency(sectorNumber, FALSE);
+    int count;
 
     ASSERT(!active); // only one request at a time
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
 
     DEBUG(dbgDisk, "Reading from sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+    if (image != NULL)
+        bcopy(image + SectorSize * sectorNumber + MagicSize, data, SectorSize);
+    else
+    {
+        // past the end of a short disk file, a sector reads as zeros
+        Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+        count = ReadPartial(fileno, data, SectorSize);
+        if (count < SectorSize)
+            bzero(data + max(count, 0), SectorSize - max(count, 0));
+    }
     if (debug->IsEnabled('d'))
         PrintSector(FALSE, sectorNumber, data);
 
@@ -140,8 +182,17 @@ void Disk::WriteRequest(int sectorNumber, char *data)
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
 
     DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    if (image != NULL)
+    {
+        bcopy(data, image + SectorSize * sectorNumber + MagicSize, SectorSize);
+        if (syncPolicy == DiskSyncWrite)
+            SyncFile(image + SectorSize * sectorNumber + MagicSize, SectorSize);
+    }
+    else
+    {
+        Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
+        WriteFile(fileno, data, SectorSize);
+    }
     if (debug->IsEnabled('d'))
         PrintSector(TRUE, sectorNumber, data);
 
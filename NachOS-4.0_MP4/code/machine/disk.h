@@ -34,6 +34,15 @@
 // and an interrupt is invoked later to signal that the operation completed.
 //
 // The physical disk is in fact simulated via operations on a UNIX file.
+// The file is mapped into memory when the host allows it, so that a
+// sector is transferred with a memory copy rather than two system
+// calls; this does not change the simulated time of a request.
+// Changes then reach the host disk whenever the host decides, unless
+// a sync policy asks for more (-dsync on the command line):
+//
+//	DiskSyncNone  -- leave it to the host
+//	DiskSyncHalt  -- flush the whole image when Nachos halts
+//	DiskSyncWrite -- flush each sector as it is written
 //
 // To make life a little more realistic, the simulated time for
 // each operation reflects a "track buffer" -- RAM to store the contents
@@ -53,6 +62,8 @@ const int SectorsPerTrack  = 16384;	// number of sectors per disk track
 const int NumTracks = 32;		// number of tracks per disk
 const int NumSectors = (SectorsPerTrack * NumTracks); // total # of sectors per disk
 
+enum DiskSyncPolicy { DiskSyncNone, DiskSyncHalt, DiskSyncWrite };
+
 class Disk : public CallBackObj {
   public:
     Disk(CallBackObj *toCall);          // Create a simulated disk.  
@@ -78,6 +89,10 @@ class Disk : public CallBackObj {
   private:
     int fileno;				// UNIX file number for simulated disk 
     char diskname[32];			// name of simulated disk's file
+    char *image;			// the file mapped into memory, NULL
+					// if it is accessed with read/write
+    DiskSyncPolicy syncPolicy;		// when to flush "image" to the
+					// host disk
     CallBackObj *callWhenDone;		// Invoke when any disk request finishes
     bool active;     			// Is a disk operation in progress?
     int lastSector;			// The previous disk request 
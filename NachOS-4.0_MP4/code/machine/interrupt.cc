@@ -253,6 +253,9 @@ void Interrupt::Halt()
     cout << "This is halt\n";
     kernel->stats->Print();
 	*/
+#ifndef FILESYS_STUB
+    kernel->fileSystem->Sync(); // commit metadata still in the log
+#endif
     delete debug;
 
     delete kernel; // Never returns.
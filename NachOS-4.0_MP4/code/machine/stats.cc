@@ -20,6 +20,8 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numPrefetchReads = numPrefetchHits = numPrefetchWasted = 0;
+    numJournalCommits = numJournalSectors = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
 }
@@ -37,6 +39,11 @@ Statistics::Print()
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
+    cout << "Read-ahead: sectors " << numPrefetchReads;
+		cout << ", hits " << numPrefetchHits;
+		cout << ", wasted " << numPrefetchWasted << "\n";
+    cout << "Journal: commits " << numJournalCommits;
+		cout << ", sectors " << numJournalSectors << "\n";
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
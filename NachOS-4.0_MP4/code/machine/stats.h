@@ -30,6 +30,11 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numPrefetchReads;	// number of sectors read ahead
+    int numPrefetchHits;	// number of reads satisfied by read-ahead
+    int numPrefetchWasted;	// number of sectors read ahead but never used
+    int numJournalCommits;	// number of metadata transactions committed
+    int numJournalSectors;	// number of sectors written through the log
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
@@ -30,6 +30,8 @@ Kernel::Kernel(int argc, char **argv)
     debugUserProg = FALSE;
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
+    diskPolicy = NULL;         // default is C-LOOK
+    diskSync = NULL;           // default is to leave it to the host
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
@@ -60,6 +62,14 @@ Kernel::Kernel(int argc, char **argv)
 	    	ASSERT(i + 1 < argc);
 	    	consoleOut = argv[i + 1];
 	    	i++;
+		} else if (strcmp(argv[i], "-ds") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	diskPolicy = argv[i + 1];
+	    	i++;
+		} else if (strcmp(argv[i], "-dsync") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	diskSync = argv[i + 1];
+	    	i++;
 #ifndef FILESYS_STUB
 		} else if (strcmp(argv[i], "-f") == 0) {
 	    	formatFlag = TRUE;
@@ -76,6 +86,8 @@ Kernel::Kernel(int argc, char **argv)
             cout << "Partial usage: nachos [-rs randomSeed]\n";
 	   		cout << "Partial usage: nachos [-s]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
+            cout << "Partial usage: nachos [-ds fifo|sstf|scan|clook]\n";
+            cout << "Partial usage: nachos [-dsync none|halt|write]\n";
 #ifndef FILESYS_STUB
 	    	cout << "Partial usage: nachos [-nf]\n";
 #endif
@@ -109,7 +121,10 @@ Kernel::Initialize()
     machine = new Machine(debugUserProg);
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
-    synchDisk = new SynchDisk();    //
+    if (diskPolicy != NULL)
+        synchDisk = new SynchDisk(SynchDisk::ParsePolicy(diskPolicy));
+    else
+        synchDisk = new SynchDisk();
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
@@ -215,6 +230,49 @@ Kernel::ConsoleTest() {
 
 }
 
+//----------------------------------------------------------------------
+// Kernel::DiskTest
+//      Measure the disk scheduling policy: several threads read
+//      sectors scattered over the whole disk at the same time, and
+//      the simulated time until all of them finish is reported.
+//      Run it once per "-ds" policy to compare them.
+//----------------------------------------------------------------------
+
+static const int DiskTestThreads = 8;
+static const int DiskTestReads = 32;
+static Semaphore *diskTestDone;
+
+static void
+DiskTestHelper(int which)
+{
+    char data[SectorSize];
+    unsigned int seed = which + 1;
+
+    for (int i = 0; i < DiskTestReads; i++) {
+        seed = seed * 1103515245 + 12345;   // same sectors on every run
+        kernel->synchDisk->ReadSector((seed >> 8) % NumSectors, data);
+    }
+    diskTestDone->V();
+}
+
+void
+Kernel::DiskTest() {
+    int start = stats->totalTicks;
+
+    diskTestDone = new Semaphore("disk test", 0);
+    for (int i = 0; i < DiskTestThreads; i++) {
+        Thread *t = new Thread("disk test", threadNum++);
+        t->Fork((VoidFunctionPtr) DiskTestHelper, (void *) i);
+    }
+    for (int i = 0; i < DiskTestThreads; i++)
+        diskTestDone->P();
+    delete diskTestDone;
+
+    cout << "Disk test: " << DiskTestThreads * DiskTestReads
+         << " reads by " << DiskTestThreads << " threads in "
+         << stats->totalTicks - start << " ticks\n";
+}
+
 //----------------------------------------------------------------------
 // Kernel::NetworkTest
 //      Test whether the post office is working. On machines #0 and #1, do:
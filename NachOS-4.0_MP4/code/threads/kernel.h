@@ -46,6 +46,7 @@ class Kernel {
 	
     void ConsoleTest();         // interactive console self test
     void NetworkTest();         // interactive 2-machine network test
+    void DiskTest();            // time concurrent disk requests
 	Thread* getThread(int threadID){return t[threadID];}    
 
 	#ifdef FILESYS_STUB	
@@ -69,6 +70,8 @@ class Kernel {
     PostOfficeOutput *postOfficeOut;
 
     int hostName;               // machine identifier
+    char *diskSync;             // when to flush the disk image to
+                                // the host disk, NULL for never
 
   private:
 
@@ -81,6 +84,8 @@ class Kernel {
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
+    char *diskPolicy;           // disk scheduling policy, NULL for
+                                // the default
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
 #endif
@@ -5,9 +5,10 @@
 // Usage: nachos -d <debugflags> -rs <random seed #>
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
 //              -f -cp <unix file> <nachos file>
-//              -p <nachos file> -r <nachos file> -l -D
+//              -p <nachos file> -cpout <nachos file> <unix file>
+//              -r <nachos file> -l -D -fsck -fsckfix
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -T -ds <disk policy> -dsync <sync policy>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
@@ -21,14 +22,21 @@
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -T time concurrent disk reads (see Kernel::DiskTest)
+//    -ds sets the disk scheduling policy: fifo, sstf, scan or clook
+//    -dsync sets when the disk image is flushed to the host disk:
+//       none, halt or write (see machine/disk.h)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
+//    -cpout copies a file from Nachos out to UNIX
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system
+//    -fsck checks the file system for consistency
+//    -fsckfix checks it, and repairs the free map
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
@@ -44,6 +52,7 @@
 #include "main.h"
 #include "filesys.h"
 #include "openfile.h"
+#include "disk.h"
 #include "sysdep.h"
 
 // global variables
@@ -63,11 +72,13 @@ Cleanup(int x)
 }
 
 //-------------------------------------------------------------------
-// Constant used by "Copy" and "Print"
+// Constant used by "Copy", "Print" and "Export"
 //   It is the number of bytes read from the Unix file (for Copy)
-//   or the Nachos file (for Print) by each read operation
+//   or the Nachos file (for Print and Export) by each read operation.
+//   A whole number of sectors, so that every transfer but the last
+//   covers full sectors and goes to the disk as one batch.
 //-------------------------------------------------------------------
-static const int TransferSize = 128;
+static const int TransferSize = 256 * SectorSize;
 
 #ifndef FILESYS_STUB
 //----------------------------------------------------------------------
@@ -94,9 +105,10 @@ static void Copy(char *from, char *to)
     fileLength = Tell(fd);
     Lseek(fd, 0, 0);
 
-    // Create a Nachos file of the same length
+    // Create an empty Nachos file; Reserve grows it to the same length
+    // in transactions small enough for the metadata log
     DEBUG('f', "Copying file " << from << " of size " << fileLength << " to file " << to);
-    if (!kernel->fileSystem->Create(to, fileLength))
+    if (!kernel->fileSystem->Create(to, 0))
     { // Create Nachos file
         printf("Copy: couldn't create output file %s\n", to);
         Close(fd);
@@ -106,6 +118,16 @@ static void Copy(char *from, char *to)
     openFile = kernel->fileSystem->Open(to);
     ASSERT(openFile != NULL);
 
+    // Give the whole file its disk blocks at once, in one run
+    if (!openFile->Reserve(fileLength))
+    {
+        printf("Copy: not enough space for %s\n", to);
+        delete openFile;
+        kernel->fileSystem->Remove(to);
+        Close(fd);
+        return;
+    }
+
     // Copy the data in TransferSize chunks
     buffer = new char[TransferSize];
     while ((amountRead = ReadPartial(fd, buffer, sizeof(char) * TransferSize)) > 0)
@@ -127,7 +149,7 @@ static void Copy(char *from, char *to)
 void Print(char *name)
 {
     OpenFile *openFile;
-    int i, amountRead;
+    int amountRead;
     char *buffer;
 
     if ((openFile = kernel->fileSystem->Open(name)) == NULL)
@@ -138,14 +160,49 @@ void Print(char *name)
 
     buffer = new char[TransferSize];
     while ((amountRead = openFile->Read(buffer, TransferSize)) > 0)
-        for (i = 0; i < amountRead; i++)
-            printf("%c", buffer[i]);
+        fwrite(buffer, sizeof(char), amountRead, stdout);
     delete[] buffer;
 
     delete openFile; // close the Nachos file
     return;
 }
 
+#ifndef FILESYS_STUB
+//----------------------------------------------------------------------
+// Export
+//      Copy the contents of the Nachos file "from" to the UNIX file "to"
+//----------------------------------------------------------------------
+
+static void Export(char *from, char *to)
+{
+    int fd;
+    OpenFile *openFile;
+    int amountRead;
+    char *buffer;
+
+    if ((openFile = kernel->fileSystem->Open(from)) == NULL)
+    {
+        printf("Export: unable to open file %s\n", from);
+        return;
+    }
+    if ((fd = OpenForWrite(to)) < 0)
+    {
+        printf("Export: couldn't open output file %s\n", to);
+        delete openFile;
+        return;
+    }
+
+    buffer = new char[TransferSize];
+    while ((amountRead = openFile->Read(buffer, TransferSize)) > 0)
+        WriteFile(fd, buffer, amountRead);
+    delete[] buffer;
+
+    delete openFile; // close the Nachos file
+    Close(fd);
+}
+
+#endif // FILESYS_STUB
+
 //----------------------------------------------------------------------
 // MP4 mod tag
 // CreateDirectory
@@ -182,10 +239,13 @@ int main(int argc, char **argv)
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    bool diskTestFlag = false;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;   // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL; // name of copied file in Nachos
     char *printFileName = NULL;
+    char *exportNachosFileName = NULL; // Nachos file to be copied out
+    char *exportUnixFileName = NULL;   // name of the copy in UNIX
     char *removeFileName = NULL;
     bool dirListFlag = false;
     bool dumpFlag = false;
@@ -195,6 +255,8 @@ int main(int argc, char **argv)
     bool mkdirFlag = false;
     bool recursiveListFlag = false;
     bool recursiveRemoveFlag = false;
+    bool checkFlag = false;
+    bool repairFlag = false;
 #endif //FILESYS_STUB
 
     // some command line arguments are handled here.
@@ -230,6 +292,10 @@ int main(int argc, char **argv)
         {
             networkTestFlag = TRUE;
         }
+        else if (strcmp(argv[i], "-T") == 0)
+        {
+            diskTestFlag = TRUE;
+        }
 #ifndef FILESYS_STUB
         else if (strcmp(argv[i], "-cp") == 0)
         {
@@ -244,6 +310,13 @@ int main(int argc, char **argv)
             printFileName = argv[i + 1];
             i++;
         }
+        else if (strcmp(argv[i], "-cpout") == 0)
+        {
+            ASSERT(i + 2 < argc);
+            exportNachosFileName = argv[i + 1];
+            exportUnixFileName = argv[i + 2];
+            i += 2;
+        }
         else if (strcmp(argv[i], "-r") == 0)
         {
             ASSERT(i + 1 < argc);
@@ -288,6 +361,15 @@ int main(int argc, char **argv)
         {
             dumpFlag = true;
         }
+        else if (strcmp(argv[i], "-fsck") == 0)
+        {
+            checkFlag = true;
+        }
+        else if (strcmp(argv[i], "-fsckfix") == 0)
+        {
+            checkFlag = true;
+            repairFlag = true;
+        }
 #endif //FILESYS_STUB
         else if (strcmp(argv[i], "-u") == 0)
         {
@@ -297,7 +379,8 @@ int main(int argc, char **argv)
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
-            cout << "Partial usage: nachos [-l] [-D]\n";
+            cout << "Partial usage: nachos [-cpout NachosFile UnixFile]\n";
+            cout << "Partial usage: nachos [-l] [-D] [-fsck] [-fsckfix]\n";
 #endif //FILESYS_STUB
         }
     }
@@ -325,8 +408,16 @@ int main(int argc, char **argv)
     {
         kernel->NetworkTest(); // two-machine test of the network
     }
+    if (diskTestFlag)
+    {
+        kernel->DiskTest(); // time the disk scheduling policy
+    }
 
 #ifndef FILESYS_STUB
+    if (checkFlag)
+    {
+        kernel->fileSystem->Check(repairFlag);
+    }
     if (removeFileName != NULL)
     {
         kernel->fileSystem->Remove(removeFileName);
@@ -357,6 +448,10 @@ int main(int argc, char **argv)
     {
         Print(printFileName);
     }
+    if (exportNachosFileName != NULL && exportUnixFileName != NULL)
+    {
+        Export(exportNachosFileName, exportUnixFileName);
+    }
 #endif // FILESYS_STUB
 
     // finally, run an initial user program if requested to do so
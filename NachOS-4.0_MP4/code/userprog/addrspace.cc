@@ -79,6 +79,8 @@ AddrSpace::AddrSpace()
     
     // zero out the entire address space
     bzero(kernel->machine->mainMemory, MemorySize);
+
+    fileTable = new FileTable;
 }
 
 //----------------------------------------------------------------------
@@ -89,6 +91,7 @@ AddrSpace::AddrSpace()
 AddrSpace::~AddrSpace()
 {
    delete pageTable;
+   delete fileTable;
 }
 
 
@@ -15,6 +15,7 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "filetable.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
 
@@ -39,6 +40,8 @@ class AddrSpace {
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    FileTable *fileTable;		// Files opened by this program
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
@@ -186,6 +186,20 @@ void ExceptionHandler(ExceptionType which)
 			ASSERTNOTREACHED();
 			break;
 
+		case SC_Seek:
+			{
+				int position = kernel->machine->ReadRegister(4);
+				OpenFileId id = kernel->machine->ReadRegister(5);
+				status = SysSeek(position, id);
+				kernel->machine->WriteRegister(2, (int) status);
+			}
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			return;	
+			ASSERTNOTREACHED();
+			break;
+
 		case SC_Close:
 			{
 				OpenFileId id = kernel->machine->ReadRegister(4);
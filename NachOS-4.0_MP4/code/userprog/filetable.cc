@@ -0,0 +1,83 @@
+// filetable.cc
+//	Routines to manage the per-process table of open file
+//	descriptors.  See filetable.h for details.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "filetable.h"
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize an empty table of open file descriptors.
+//----------------------------------------------------------------------
+
+FileTable::FileTable()
+{
+    for (int i = 0; i < MaxOpenFiles; i++)
+	table[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// FileTable::~FileTable
+// 	Close any files the process left open.
+//----------------------------------------------------------------------
+
+FileTable::~FileTable()
+{
+    for (int i = 0; i < MaxOpenFiles; i++)
+	delete table[i];
+}
+
+//----------------------------------------------------------------------
+// FileTable::Add
+// 	Install an open file in the first free descriptor, and return
+//	its id.  Return -1 if the process already has too many files open.
+//
+//	"file" -- the open file; owned by the table from now on
+//----------------------------------------------------------------------
+
+OpenFileId
+FileTable::Add(OpenFile *file)
+{
+    for (int i = FirstFileId; i < MaxOpenFiles; i++) {
+	if (table[i] == NULL) {
+	    table[i] = file;
+	    return i;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Get
+// 	Return the open file with id "id", or NULL if there is none.
+//----------------------------------------------------------------------
+
+OpenFile *
+FileTable::Get(OpenFileId id)
+{
+    if (id < FirstFileId || id >= MaxOpenFiles)
+	return NULL;
+    return table[id];
+}
+
+//----------------------------------------------------------------------
+// FileTable::Remove
+// 	Close the open file with id "id", and free its descriptor.
+//	Return FALSE if "id" is not an open file.
+//----------------------------------------------------------------------
+
+bool
+FileTable::Remove(OpenFileId id)
+{
+    OpenFile *file = Get(id);
+
+    if (file == NULL)
+	return FALSE;
+    delete file;
+    table[id] = NULL;
+    return TRUE;
+}
@@ -0,0 +1,45 @@
+// filetable.h
+//	Data structures for the per-process table of open file
+//	descriptors.
+//
+//	Each address space keeps its own table, mapping the OpenFileId
+//	returned by the Open system call to an OpenFile handle.  Every
+//	handle has its own seek position, while the file header itself
+//	is shared through the system-wide open file table (openfile.h).
+//
+//	Ids SysConsoleInput and SysConsoleOutput are reserved for the
+//	console, so the first file opened by a process gets id 2.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include "copyright.h"
+#include "openfile.h"
+
+#define MaxOpenFiles 20 // number of descriptors per process,
+                        // including the two console ids
+#define FirstFileId 2   // ids below this are SysConsoleInput and
+                        // SysConsoleOutput (cf. syscall.h)
+
+typedef int OpenFileId;
+
+class FileTable {
+  public:
+    FileTable();		// Initialize an empty descriptor table
+    ~FileTable();		// Close every file still open
+
+    OpenFileId Add(OpenFile *file);	// Install "file", returning its id,
+					// or -1 if the table is full
+    OpenFile *Get(OpenFileId id);	// Return the file for "id", or NULL
+					// if "id" is not an open file
+    bool Remove(OpenFileId id);		// Close "id"; FALSE if it wasn't open
+
+  private:
+    OpenFile *table[MaxOpenFiles];	// Open files, indexed by id
+};
+
+#endif // FILETABLE_H
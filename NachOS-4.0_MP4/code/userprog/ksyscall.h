@@ -36,19 +36,40 @@ int SysCreate(char *filename , int init){
 }
 
 OpenFileId SysOpen(char *name){
-	return kernel->fileSystem->OpenAFile(name);
+	OpenFile *openFile = kernel->fileSystem->Open(name);
+	OpenFileId id;
+
+	if (openFile == NULL) return -1;
+	id = kernel->currentThread->space->fileTable->Add(openFile);
+	if (id < 0) delete openFile;	// too many open files
+	return id;
 }
 
 int SysRead(char *buffer, int size, OpenFileId id){
-	return kernel->fileSystem->Read(buffer, size, id);
+	OpenFile *openFile = kernel->currentThread->space->fileTable->Get(id);
+
+	if (openFile == NULL || size < 0) return -1;
+	return openFile->Read(buffer, size);
 }
 
 int SysWrite(char *buffer, int size, OpenFileId id){
-	return kernel->fileSystem->Write(buffer, size, id);
+	OpenFile *openFile = kernel->currentThread->space->fileTable->Get(id);
+
+	if (openFile == NULL || size < 0) return -1;
+	return openFile->Write(buffer, size);
+}
+
+int SysSeek(int position, OpenFileId id){
+	OpenFile *openFile = kernel->currentThread->space->fileTable->Get(id);
+
+	if (openFile == NULL || position < 0) return -1;
+	openFile->Seek(position);
+	return 1;
 }
 
 int SysClose(OpenFileId id){
-	return kernel->fileSystem->Close(id);
+	if (!kernel->currentThread->space->fileTable->Remove(id)) return -1;
+	return 1;
 }
 
 // end